@@ -0,0 +1,151 @@
+#ifndef JUNCTION_CONFIG_H
+#define JUNCTION_CONFIG_H
+
+#include <Arduino.h>
+
+// The junction described as data: the signal groups (one per signal head with
+// its lamp pins), the phases with the aspect every group shows, and the order
+// in which the phases run. The controller only walks these tables. Another
+// junction layout needs a different JunctionConfig.cpp, the phase indices in
+// TrafficLightState below, the lamp pins in PinDefinitions.h/.cpp and the
+// dashboard page in WebServerHandler.cpp, whose phase list and colours name
+// the phases and heads of this T-junction.
+
+const int NO_PIN = -1;
+const uint8_t NO_PHASE = 0xFF;
+const uint8_t MAX_SIGNAL_GROUPS = 8;
+const uint8_t MAX_PHASES = 12;
+
+enum Aspect : uint8_t
+{
+    ASPECT_DARK,
+    ASPECT_RED,
+    ASPECT_RED_YELLOW,
+    ASPECT_YELLOW,
+    ASPECT_GREEN,
+    ASPECT_YELLOW_FLASHING
+};
+
+struct SignalGroup
+{
+    const char *name;
+    int red;    // NO_PIN if the head has no such lamp
+    int yellow;
+    int green;
+    bool pedestrian; // Green blinks at the end of pedestrian phases
+};
+
+// Phase flags
+const uint8_t PHASE_CLEARANCE = 0x01;         // A pending pedestrian demand is served after this phase
+const uint8_t PHASE_SERVES_PEDESTRIAN = 0x02; // Leaving this phase clears the pedestrian demand
+const uint8_t PHASE_SERVES_VEHICLE = 0x04;    // Leaving this phase clears the vehicle demand
+const uint8_t PHASE_FLASHING = 0x08;          // Night flashing, held while the timing plan asks for it
+
+struct Phase
+{
+    const char *name;
+    unsigned long duration;       // ms
+    unsigned long demandDuration; // ms, replaces duration while a vehicle demand is pending (0 = unchanged)
+    unsigned long blinkTail;      // ms at the end of the phase in which pedestrian greens blink (0 = none)
+    uint8_t flags;                // PHASE_* flags
+    uint8_t after;                // Phase that follows instead of the next sequence step (NO_PHASE = next step)
+    uint8_t aspects[MAX_SIGNAL_GROUPS];
+};
+
+extern const SignalGroup SIGNAL_GROUPS[];
+extern const uint8_t SIGNAL_GROUP_COUNT;
+
+// The possible states of the traffic light system, indices into PHASES[].
+// Has to list the phases in the order of JunctionConfig.cpp.
+enum TrafficLightState
+{
+    MAIN_GREEN,
+    MAIN_YELLOW,
+    ALL_RED,
+    SIDE_RED_YELLOW,
+    SIDE_GREEN,
+    SIDE_YELLOW,
+    MAIN_RED_YELLOW,
+    PEDESTRIAN_GREEN,
+    FLASHING_YELLOW
+};
+
+extern const Phase PHASES[];
+extern const uint8_t PHASE_COUNT;
+
+// Phases of the normal cycle, in order. Phases not listed here are only
+// entered on demand (PEDESTRIAN_PHASE) or by a /set command.
+extern const uint8_t PHASE_SEQUENCE[];
+extern const uint8_t PHASE_SEQUENCE_LENGTH;
+
+// Phase inserted after a clearance phase when the pedestrian button was pressed
+extern const uint8_t PEDESTRIAN_PHASE;
+
+// Group whose yellow lamp flashes when a vehicle is detected
+extern const uint8_t VEHICLE_FEEDBACK_GROUP;
+
+// Phase shown while a PLAN_FLASHING timing plan is active
+extern const uint8_t FLASHING_PHASE;
+
+// Green requested by the preemption input (PREEMPT_INPUT)
+extern const uint8_t PREEMPTION_PHASE;
+
+// ms after which a preemption ends even if it was not released
+extern const unsigned long PREEMPTION_TIMEOUT;
+
+// ms a green is shown at least before a preemption may cut it short
+extern const unsigned long MINIMUM_GREEN;
+
+// --- Timing plans ---
+
+enum PlanMode : uint8_t
+{
+    PLAN_CYCLE,         // Run the phase sequence continuously
+    PLAN_REST_IN_GREEN, // Stay in the first sequence phase until a demand arrives
+    PLAN_FLASHING       // Show FLASHING_PHASE
+};
+
+struct TimingPlan
+{
+    const char *name;
+    uint8_t mode;                        // PlanMode
+    unsigned long durations[MAX_PHASES]; // ms per phase, 0 = duration from PHASES[]
+};
+
+extern const TimingPlan TIMING_PLANS[];
+extern const uint8_t TIMING_PLAN_COUNT;
+
+// Index of the timing plan kept in RAM, written over the supervisory link
+// (see setCustomTimingPlan() in TrafficLightController.h)
+const uint8_t CUSTOM_TIMING_PLAN = 0xFE;
+
+// ms a timing plan may hold a phase at most
+extern const unsigned long MAXIMUM_PHASE_DURATION;
+
+// Plan used while the clock has not been set
+extern const uint8_t DEFAULT_TIMING_PLAN;
+
+// Days for ScheduleEntry::days, bit 0 = Sunday
+const uint8_t SUNDAY = 0x01;
+const uint8_t MONDAY = 0x02;
+const uint8_t TUESDAY = 0x04;
+const uint8_t WEDNESDAY = 0x08;
+const uint8_t THURSDAY = 0x10;
+const uint8_t FRIDAY = 0x20;
+const uint8_t SATURDAY = 0x40;
+const uint8_t WEEKDAYS = MONDAY | TUESDAY | WEDNESDAY | THURSDAY | FRIDAY;
+const uint8_t WEEKEND = SATURDAY | SUNDAY;
+const uint8_t EVERY_DAY = WEEKDAYS | WEEKEND;
+
+// A plan starts at the given time on each of the days and runs until the next entry starts.
+struct ScheduleEntry
+{
+    uint8_t days;   // Bit mask of days
+    uint16_t start; // Minutes after midnight
+    uint8_t plan;   // Index into TIMING_PLANS
+};
+
+extern const ScheduleEntry WEEKLY_SCHEDULE[];
+extern const uint8_t WEEKLY_SCHEDULE_LENGTH;
+
+#endif // JUNCTION_CONFIG_H
@@ -3,6 +3,16 @@
 
 #include <Arduino.h>
 
+// Lamp output backend, select with -D LAMP_DRIVER=LAMP_DRIVER_SHIFT_REGISTER.
+// With the shift register backend the LAMPx_* values are output numbers on
+// the 74HC595 chain (Q0 of the first register = 0) instead of Arduino pins.
+#define LAMP_DRIVER_DIRECT 0
+#define LAMP_DRIVER_SHIFT_REGISTER 1
+
+#ifndef LAMP_DRIVER
+#define LAMP_DRIVER LAMP_DRIVER_DIRECT
+#endif
+
 extern int LAMP1_RED;
 extern int LAMP1_YELLOW;
 extern int LAMP1_GREEN;
@@ -22,5 +32,13 @@ extern int LAMP2_RED_PED;
 
 extern int PED_BUTTON;
 extern int VEHICLE_BUTTON;
+extern int PREEMPT_INPUT;
+
+#if LAMP_DRIVER == LAMP_DRIVER_SHIFT_REGISTER
+// Chain on the hardware SPI port (MOSI D11, SCK D13), all registers share one latch.
+// At most 4 registers, blinking keeps its lamps in 32 bit masks (LampDriver.cpp).
+const uint8_t SHIFT_REGISTER_COUNT = 2;
+extern int SHIFT_REGISTER_LATCH;
+#endif
 
 #endif // PIN_DEFINITIONS_H
\ No newline at end of file
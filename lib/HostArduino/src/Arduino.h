@@ -0,0 +1,126 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Minimal stand-in for the Arduino API so that the controller modules can be
+// built and run on a PC. Time is simulated: millis() only moves when the host
+// program sets or advances it (delay() advances it too), unless the program
+// switches to real time with hostUseRealTime(). Every pin level written with
+// digitalWrite() is kept in a pin image that can be inspected.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define DEC 10
+#define HEX 16
+
+#define LED_BUILTIN 13
+
+// Same numbering as the Nano 33 IoT variant
+enum
+{
+    A0 = 14,
+    A1,
+    A2,
+    A3,
+    A4,
+    A5,
+    A6,
+    A7
+};
+
+const int HOST_PIN_COUNT = 32;
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+// There are no interrupts on the host; timer handlers are called by the host program
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+// --- Host-only helpers ---
+void hostSetMillis(unsigned long ms);
+void hostAdvanceMillis(unsigned long ms);
+void hostResetPins();
+void hostSetSerialOutput(bool enabled);
+
+// millis() and micros() follow the wall clock from now on, counting from 0,
+// and delay() sleeps. For programs that talk to real clients, like the host web server.
+void hostUseRealTime();
+
+// Serial reads from and writes to this file descriptor (a pty, say) instead
+// of writing to stdout; -1 goes back to stdout.
+void hostSetSerialPort(int fd);
+
+class String
+{
+public:
+    String() {}
+    String(const char *s) : str(s ? s : "") {}
+    String(const std::string &s) : str(s) {}
+
+    unsigned int length() const { return str.length(); }
+    const char *c_str() const { return str.c_str(); }
+    bool operator==(const char *s) const { return str == s; }
+    bool operator==(const String &s) const { return str == s.str; }
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const char *s, unsigned int from = 0) const;
+    String substring(unsigned int from, unsigned int to) const;
+    void trim();
+
+private:
+    std::string str;
+};
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+
+    size_t print(const char *s) { return write(s); }
+    size_t print(const String &s) { return write(s.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T &value) { return print(value) + println(); }
+    template <typename T>
+    size_t println(const T &value, int format) { return print(value, format) + println(); }
+};
+
+// Writes to stdout, or to the port set with hostSetSerialPort()
+class HostSerial : public Print
+{
+public:
+    void begin(unsigned long) {}
+    operator bool() const { return true; }
+    int available();
+    int read();
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+};
+
+extern HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,239 @@
+#include "Arduino.h"
+#include <math.h>
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+
+HostSerial Serial;
+
+static unsigned long hostMillis = 0;
+static uint8_t pinLevels[HOST_PIN_COUNT];
+static uint8_t pinModes[HOST_PIN_COUNT];
+static bool serialOutput = true;
+static bool realTime = false;
+static int serialPort = -1;
+static std::chrono::steady_clock::time_point realTimeStart;
+
+// --- Pins and time ---
+
+void pinMode(int pin, int mode)
+{
+    if (pin >= 0 && pin < HOST_PIN_COUNT)
+        pinModes[pin] = mode;
+}
+
+void digitalWrite(int pin, int value)
+{
+    if (pin >= 0 && pin < HOST_PIN_COUNT)
+        pinLevels[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(int pin)
+{
+    if (pin < 0 || pin >= HOST_PIN_COUNT)
+        return LOW;
+    // Unconnected pull-up inputs read HIGH, like a released button
+    if (pinModes[pin] == INPUT_PULLUP)
+        return HIGH;
+    return pinLevels[pin];
+}
+
+unsigned long millis()
+{
+    if (realTime)
+        return micros() / 1000UL;
+    return hostMillis;
+}
+
+unsigned long micros()
+{
+    if (realTime)
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - realTimeStart).count();
+    return hostMillis * 1000UL;
+}
+
+void delay(unsigned long ms)
+{
+    if (realTime)
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    else
+        hostMillis += ms;
+}
+
+void hostSetMillis(unsigned long ms)
+{
+    hostMillis = ms;
+}
+
+void hostAdvanceMillis(unsigned long ms)
+{
+    hostMillis += ms;
+}
+
+void hostResetPins()
+{
+    memset(pinLevels, 0, sizeof(pinLevels));
+    memset(pinModes, 0, sizeof(pinModes));
+}
+
+void hostSetSerialOutput(bool enabled)
+{
+    serialOutput = enabled;
+}
+
+void hostUseRealTime()
+{
+    realTime = true;
+    realTimeStart = std::chrono::steady_clock::now();
+}
+
+void hostSetSerialPort(int fd)
+{
+    serialPort = fd;
+}
+
+// --- String ---
+
+int String::indexOf(char c, unsigned int from) const
+{
+    size_t pos = str.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const char *s, unsigned int from) const
+{
+    size_t pos = str.find(s, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+    if (from > str.length())
+        return String();
+    return String(str.substr(from, to - from));
+}
+
+void String::trim()
+{
+    size_t begin = str.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos)
+    {
+        str.clear();
+        return;
+    }
+    size_t end = str.find_last_not_of(" \t\r\n");
+    str = str.substr(begin, end - begin + 1);
+}
+
+// --- Print ---
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--)
+        n += write(*buffer++);
+    return n;
+}
+
+size_t Print::print(long n, int base)
+{
+    if (n < 0 && base == DEC)
+        return print('-') + print((unsigned long)-n, base);
+    return print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+    char buf[8 * sizeof(long) + 1];
+    char *p = &buf[sizeof(buf) - 1];
+    *p = '\0';
+    do
+    {
+        unsigned long digit = n % base;
+        *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        n /= base;
+    } while (n);
+    return write(p);
+}
+
+// Same algorithm as the Arduino core (rounds by adding half a unit of the last
+// digit), not printf(), so the host prints the digits the board prints
+size_t Print::print(double n, int digits)
+{
+    if (isnan(n))
+        return write("nan");
+    if (isinf(n))
+        return write("inf");
+    if (n > 4294967040.0 || n < -4294967040.0)
+        return write("ovf");
+
+    size_t count = 0;
+    if (n < 0.0)
+    {
+        count += print('-');
+        n = -n;
+    }
+    double rounding = 0.5;
+    for (int i = 0; i < digits; i++)
+        rounding /= 10.0;
+    n += rounding;
+
+    unsigned long integer = (unsigned long)n;
+    double remainder = n - (double)integer;
+    count += print(integer);
+    if (digits > 0)
+        count += print('.');
+    while (digits-- > 0)
+    {
+        remainder *= 10.0;
+        unsigned int digit = (unsigned int)remainder;
+        count += print(digit);
+        remainder -= digit;
+    }
+    return count;
+}
+
+// --- Serial ---
+
+int HostSerial::available()
+{
+    int count = 0;
+    if (serialPort < 0 || ioctl(serialPort, FIONREAD, &count) < 0)
+        return 0;
+    return count;
+}
+
+int HostSerial::read()
+{
+    uint8_t c;
+    if (available() <= 0 || ::read(serialPort, &c, 1) != 1)
+        return -1;
+    return c;
+}
+
+size_t HostSerial::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t HostSerial::write(const uint8_t *buffer, size_t size)
+{
+    if (serialPort >= 0)
+    {
+        // Blocks like the USB serial port does while the other side does not read
+        size_t written = 0;
+        while (written < size)
+        {
+            ssize_t n = ::write(serialPort, buffer + written, size - written);
+            if (n <= 0)
+                break;
+            written += n;
+        }
+        return written;
+    }
+    if (serialOutput)
+        fwrite(buffer, 1, size, stdout);
+    return size;
+}
@@ -0,0 +1,19 @@
+#include "Arduino_LSM6DS3.h"
+
+LSM6DS3Class IMU;
+
+int LSM6DS3Class::readAcceleration(float &x, float &y, float &z)
+{
+    x = 0.0F;
+    y = 0.0F;
+    z = 1.0F; // g
+    return 1;
+}
+
+int LSM6DS3Class::readGyroscope(float &x, float &y, float &z)
+{
+    x = 0.0F;
+    y = 0.0F;
+    z = 0.0F; // degrees/second
+    return 1;
+}
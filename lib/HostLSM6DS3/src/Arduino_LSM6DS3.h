@@ -0,0 +1,23 @@
+#ifndef HOST_ARDUINO_LSM6DS3_H
+#define HOST_ARDUINO_LSM6DS3_H
+
+// IMU stand-in: a board lying flat and still, readings are always available.
+
+class LSM6DS3Class
+{
+public:
+    int begin() { return 1; }
+    void end() {}
+
+    int readAcceleration(float &x, float &y, float &z);
+    int accelerationAvailable() { return 1; }
+    float accelerationSampleRate() { return 104.0F; }
+
+    int readGyroscope(float &x, float &y, float &z);
+    int gyroscopeAvailable() { return 1; }
+    float gyroscopeSampleRate() { return 104.0F; }
+};
+
+extern LSM6DS3Class IMU;
+
+#endif // HOST_ARDUINO_LSM6DS3_H
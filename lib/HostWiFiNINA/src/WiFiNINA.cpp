@@ -0,0 +1,141 @@
+#include "WiFiNINA.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Connections accepted by the server and not stopped yet
+static int openSocks[MAX_SOCK_NUM];
+static int openCount = 0;
+
+static void forgetSock(int sock)
+{
+    for (int i = 0; i < openCount; i++)
+    {
+        if (openSocks[i] == sock)
+        {
+            openSocks[i] = openSocks[--openCount];
+            return;
+        }
+    }
+}
+
+// --- WiFiClient ---
+
+int WiFiClient::available()
+{
+    int count = 0;
+    if (sock < 0 || ioctl(sock, FIONREAD, &count) < 0)
+        return 0;
+    return count;
+}
+
+int WiFiClient::read()
+{
+    uint8_t c;
+    if (sock < 0 || recv(sock, &c, 1, MSG_DONTWAIT) != 1)
+        return -1;
+    return c;
+}
+
+int WiFiClient::read(uint8_t *buffer, size_t size)
+{
+    if (sock < 0)
+        return -1;
+    ssize_t n = recv(sock, buffer, size, MSG_DONTWAIT);
+    return n > 0 ? n : -1;
+}
+
+void WiFiClient::stop()
+{
+    if (sock < 0)
+        return;
+    forgetSock(sock);
+
+    // Closing with unread request headers would reset the connection and the
+    // client could lose the end of the response
+    shutdown(sock, SHUT_WR);
+    uint8_t buffer[256];
+    while (recv(sock, buffer, sizeof(buffer), MSG_DONTWAIT) > 0)
+        ;
+    close(sock);
+    sock = -1;
+}
+
+uint8_t WiFiClient::connected()
+{
+    if (sock < 0)
+        return 0;
+    uint8_t c;
+    ssize_t n = recv(sock, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+}
+
+size_t WiFiClient::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t WiFiClient::write(const uint8_t *buffer, size_t size)
+{
+    size_t sent = 0;
+    while (sock >= 0 && sent < size)
+    {
+        ssize_t n = send(sock, buffer + sent, size - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break; // The client went away, like a failed write on the module
+        sent += n;
+    }
+    return sent;
+}
+
+// --- WiFiServer ---
+
+void WiFiServer::begin()
+{
+    listenSock = socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(listenSock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(listenSock, (sockaddr *)&address, sizeof(address)) < 0 || listen(listenSock, 64) < 0)
+    {
+        perror("WiFiServer");
+        exit(2);
+    }
+    fcntl(listenSock, F_SETFL, fcntl(listenSock, F_GETFL) | O_NONBLOCK);
+}
+
+WiFiClient WiFiServer::available()
+{
+    if (listenSock < 0)
+        return WiFiClient();
+
+    // The module accepts in the background, up to its socket count
+    while (openCount < MAX_SOCK_NUM)
+    {
+        int sock = accept(listenSock, NULL, NULL);
+        if (sock < 0)
+            break;
+        openSocks[openCount++] = sock;
+    }
+
+    // Like the module, the first socket with unread data, even if it is
+    // already being served
+    for (int i = 0; i < openCount; i++)
+    {
+        WiFiClient client(openSocks[i]);
+        if (client.available())
+            return client;
+    }
+    return WiFiClient();
+}
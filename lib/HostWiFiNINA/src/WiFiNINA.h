@@ -0,0 +1,52 @@
+#ifndef HOST_WIFININA_H
+#define HOST_WIFININA_H
+
+// The part of WiFiNINA the web server uses, on TCP sockets of the PC. Like
+// the NINA module, the server accepts connections on its own and available()
+// hands out the first one that has data waiting, whether it is already being
+// served or not; a client is a socket number that can be copied and compared.
+// Reads never block, writes block until the data is in the socket buffer.
+
+#include <Arduino.h>
+
+// Sockets the server keeps open at the same time, as on the NINA module
+const int MAX_SOCK_NUM = 10;
+
+class WiFiClient : public Print
+{
+public:
+    WiFiClient() : sock(-1) {}
+    explicit WiFiClient(int sock) : sock(sock) {}
+
+    int available();
+    int read();
+    int read(uint8_t *buffer, size_t size);
+    void flush() {} // Only waits for outgoing data on the module, received data stays
+    void stop();
+    uint8_t connected();
+    operator bool() const { return sock >= 0; }
+    bool operator==(const WiFiClient &other) const { return sock == other.sock; }
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+
+private:
+    int sock;
+};
+
+class WiFiServer
+{
+public:
+    explicit WiFiServer(uint16_t port) : port(port), listenSock(-1) {}
+
+    // Listens on all interfaces. Stops the program if the port is taken.
+    void begin();
+    WiFiClient available();
+
+private:
+    uint16_t port;
+    int listenSock;
+};
+
+#endif // HOST_WIFININA_H
@@ -0,0 +1,27 @@
+# Prints code and RAM size per component of the benchmark firmware after the
+# link step, in the same CSV style as the benchmark output on Serial:
+#
+#   size,<component>,<text>,<data>,<bss>
+#
+# A component is one object file built from src/. Flash use is text + data,
+# static RAM use is data + bss.
+
+import glob
+import os
+import subprocess
+
+Import("env")
+
+
+def report_sizes(source, target, env):
+    size_tool = env.subst("$SIZETOOL")
+    src_build_dir = os.path.join(env.subst("$BUILD_DIR"), "src")
+    objects = sorted(glob.glob(os.path.join(src_build_dir, "**", "*.o"), recursive=True))
+    for obj in objects:
+        output = subprocess.check_output([size_tool, obj]).decode().splitlines()
+        text, data, bss = output[1].split()[:3]
+        component = os.path.relpath(obj, src_build_dir)[: -len(".cpp.o")]
+        print("size,%s,%s,%s,%s" % (component, text, data, bss))
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", report_sizes)
@@ -0,0 +1,108 @@
+#include "BlinkTimer.h"
+#include "JunctionConfig.h"
+#include "LampDriver.h"
+
+const uint16_t FALLBACK_TICKS = BLINK_FALLBACK_MS / BLINK_TICK_MS;
+
+static volatile bool watching = false;
+static volatile uint16_t ticksSinceFeed = 0;
+static volatile bool fellBack = false;
+
+// Shows the flashing phase without the controller, which may be stuck anywhere
+static void showFallback()
+{
+    const Phase &phase = PHASES[FLASHING_PHASE];
+    for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
+        showAspect(SIGNAL_GROUPS[i], phase.aspects[i]);
+    latchLamps();
+    fellBack = true;
+}
+
+static void blinkTimerTick()
+{
+    advanceLampBlink();
+
+    // Counts up to the limit once per stall
+    if (watching && ticksSinceFeed < FALLBACK_TICKS && ++ticksSinceFeed == FALLBACK_TICKS)
+        showFallback();
+}
+
+void feedBlinkTimer()
+{
+    ticksSinceFeed = 0;
+    watching = true;
+}
+
+bool blinkTimerFellBack()
+{
+    if (!fellBack)
+        return false;
+    fellBack = false;
+    return true;
+}
+
+#ifdef ARDUINO_ARCH_SAMD
+
+// TC3 is free on the Nano 33 IoT (tone() uses TC5, the benchmark firmware TC4 and TC5)
+const uint16_t TC3_PRESCALER = 256;
+
+static void syncTC3()
+{
+    while (TC3->COUNT16.STATUS.bit.SYNCBUSY)
+        ;
+}
+
+void initBlinkTimer()
+{
+    watching = false;
+    fellBack = false;
+
+    PM->APBCMASK.reg |= PM_APBCMASK_TC3;
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID_TCC2_TC3;
+    while (GCLK->STATUS.bit.SYNCBUSY)
+        ;
+
+    TC3->COUNT16.CTRLA.reg = TC_CTRLA_SWRST;
+    while (TC3->COUNT16.CTRLA.bit.SWRST)
+        ;
+
+    // Match frequency mode: the counter restarts at CC0, 1875 counts = 10 ms at 48 MHz / 256
+    TC3->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER_DIV256;
+    syncTC3();
+    TC3->COUNT16.CC[0].reg = F_CPU / TC3_PRESCALER * BLINK_TICK_MS / 1000 - 1;
+    syncTC3();
+    TC3->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+
+    // Below the DMAC, which has to finish the lamp frames sent from here
+    NVIC_SetPriority(TC3_IRQn, 3);
+    NVIC_EnableIRQ(TC3_IRQn);
+
+    TC3->COUNT16.CTRLA.bit.ENABLE = 1;
+    syncTC3();
+}
+
+extern "C" void TC3_Handler()
+{
+    TC3->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+    blinkTimerTick();
+}
+
+#else
+
+void initBlinkTimer()
+{
+    watching = false;
+    fellBack = false;
+}
+
+void hostBlinkTimerTick()
+{
+    blinkTimerTick();
+}
+
+void hostTriggerBlinkTimerFallback()
+{
+    showFallback();
+}
+
+#endif // ARDUINO_ARCH_SAMD
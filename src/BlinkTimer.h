@@ -0,0 +1,28 @@
+#ifndef BLINK_TIMER_H
+#define BLINK_TIMER_H
+
+#include <Arduino.h>
+
+// Calls advanceLampBlink() (LampDriver.h) every BLINK_TICK_MS from the TC3
+// interrupt, so lamps blink at their exact rates however long a loop pass
+// takes. The same interrupt watches the controller: when
+// updateTrafficController() has not run for BLINK_FALLBACK_MS, it switches
+// the lamps to FLASHING_PHASE on its own.
+
+const unsigned long BLINK_FALLBACK_MS = 2000;
+
+void initBlinkTimer();
+
+// Call on every controller update. The watch starts with the first call.
+void feedBlinkTimer();
+
+// True once after the timer has switched to the fallback.
+bool blinkTimerFellBack();
+
+#ifndef ARDUINO_ARCH_SAMD
+// Host: there is no timer interrupt, these do what it would do.
+void hostBlinkTimerTick();
+void hostTriggerBlinkTimerFallback();
+#endif
+
+#endif // BLINK_TIMER_H
@@ -0,0 +1,66 @@
+#include "Commands.h"
+#include "JunctionConfig.h"
+#include "TrafficLightController.h"
+#include "InputRecorder.h"
+#include "PlanScheduler.h"
+
+CommandResult commandSetState(uint8_t state)
+{
+    if (state >= PHASE_COUNT)
+        return COMMAND_BAD_ARGUMENT;
+
+    Serial.print("Setting state to: ");
+    Serial.println(PHASES[state].name);
+    return setTrafficLightPhase(state) ? COMMAND_OK : COMMAND_REFUSED;
+}
+
+CommandResult commandSetClock(uint32_t epoch)
+{
+    if (epoch < CLOCK_EARLIEST || epoch > CLOCK_LATEST)
+        return COMMAND_BAD_ARGUMENT;
+
+    Serial.print("Setting clock to: ");
+    Serial.println(epoch);
+    setClock(epoch);
+    return COMMAND_OK;
+}
+
+CommandResult commandSelectTimingPlan(uint8_t plan)
+{
+    if (!getTimingPlan(plan) && plan != FOLLOW_SCHEDULE)
+        return COMMAND_BAD_ARGUMENT;
+
+    overrideTimingPlan(plan);
+    return COMMAND_OK;
+}
+
+CommandResult commandWriteCustomPlan(uint8_t mode, const unsigned long *durations)
+{
+    // A capture could not replay a plan that changes under it, neither can a plan change in the middle of a cycle
+    if (isRecording() || getActiveTimingPlan() == CUSTOM_TIMING_PLAN || getTimingPlanOverride() == CUSTOM_TIMING_PLAN)
+        return COMMAND_REFUSED;
+    return setCustomTimingPlan(mode, durations) ? COMMAND_OK : COMMAND_BAD_ARGUMENT;
+}
+
+CommandResult commandPreempt(uint8_t phase)
+{
+    return requestPreemption(phase) ? COMMAND_OK : COMMAND_BAD_ARGUMENT;
+}
+
+CommandResult commandReleasePreemption()
+{
+    releasePreemption();
+    return COMMAND_OK;
+}
+
+CommandResult commandStartCapture()
+{
+    startRecording();
+    return COMMAND_OK;
+}
+
+CommandResult commandStopCapture()
+{
+    stopRecording();
+    return COMMAND_OK;
+}
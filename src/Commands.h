@@ -0,0 +1,36 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <Arduino.h>
+
+// Commands that change the controller, shared by the web interface
+// (WebServerHandler.cpp) and the supervisory link on the USB port
+// (SupervisoryLink.cpp). Checking who may send them is up to the interface.
+
+enum CommandResult : uint8_t
+{
+    COMMAND_OK,
+    COMMAND_BAD_ARGUMENT, // Unknown phase or plan, time out of range
+    COMMAND_REFUSED       // Not allowed right now, e.g. a state change while preempted
+};
+
+// Switch to a phase right away (index into PHASES).
+CommandResult commandSetState(uint8_t state);
+
+// Set the clock, local seconds since 1970, between CLOCK_EARLIEST and CLOCK_LATEST.
+CommandResult commandSetClock(uint32_t epoch);
+
+// Hold a timing plan (index into TIMING_PLANS or CUSTOM_TIMING_PLAN), FOLLOW_SCHEDULE to return to the schedule.
+CommandResult commandSelectTimingPlan(uint8_t plan);
+
+// Write the custom timing plan, see setCustomTimingPlan(). Refused while it
+// is in use or held, and while a capture is recording.
+CommandResult commandWriteCustomPlan(uint8_t mode, const unsigned long *durations);
+
+CommandResult commandPreempt(uint8_t phase);
+CommandResult commandReleasePreemption();
+
+CommandResult commandStartCapture();
+CommandResult commandStopCapture();
+
+#endif // COMMANDS_H
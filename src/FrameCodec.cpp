@@ -0,0 +1,112 @@
+#include "FrameCodec.h"
+
+uint16_t crc16(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+size_t cobsEncode(const uint8_t *data, size_t length, uint8_t *out)
+{
+    // Each block starts with a code byte: the distance to the next zero (or block end)
+    size_t codeIndex = 0;
+    size_t written = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < length; i++)
+    {
+        if (data[i] != 0)
+        {
+            out[written++] = data[i];
+            code++;
+        }
+        if (data[i] == 0 || code == 0xFF)
+        {
+            out[codeIndex] = code;
+            codeIndex = written++;
+            code = 1;
+        }
+    }
+    out[codeIndex] = code;
+    return written;
+}
+
+size_t cobsDecode(const uint8_t *data, size_t length, uint8_t *out, size_t size)
+{
+    size_t read = 0;
+    size_t written = 0;
+    while (read < length)
+    {
+        uint8_t code = data[read++];
+        if (code == 0 || read + code - 1 > length)
+            return 0;
+        for (uint8_t i = 1; i < code; i++)
+        {
+            if (data[read] == 0 || written >= size)
+                return 0;
+            out[written++] = data[read++];
+        }
+        // A full block (0xFF) carries no zero, neither does the last block
+        if (code != 0xFF && read < length)
+        {
+            if (written >= size)
+                return 0;
+            out[written++] = 0;
+        }
+    }
+    return written;
+}
+
+size_t encodeFrame(const Frame &frame, uint8_t *out)
+{
+    uint8_t data[MAX_FRAME_DATA];
+    size_t length = frame.length < MAX_FRAME_PAYLOAD ? frame.length : MAX_FRAME_PAYLOAD;
+    data[0] = frame.type;
+    data[1] = frame.sequence;
+    memcpy(data + 2, frame.payload, length);
+    putUint16(data + 2 + length, crc16(data, 2 + length));
+
+    out[0] = FRAME_DELIMITER;
+    size_t encoded = cobsEncode(data, length + 4, out + 1);
+    out[encoded + 1] = FRAME_DELIMITER;
+    return encoded + 2;
+}
+
+bool FrameReader::feed(uint8_t c, Frame &frame)
+{
+    if (c != FRAME_DELIMITER)
+    {
+        if (used < sizeof(buffer))
+            buffer[used++] = c;
+        else
+            overflow = true;
+        return false;
+    }
+
+    // Back-to-back delimiters are empty chunks, not errors
+    size_t length = used;
+    bool tooLong = overflow;
+    used = 0;
+    overflow = false;
+    if (length == 0)
+        return false;
+
+    uint8_t data[MAX_FRAME_DATA];
+    size_t decoded = tooLong ? 0 : cobsDecode(buffer, length, data, sizeof(data));
+    if (decoded < 4 || getUint16(data + decoded - 2) != crc16(data, decoded - 2))
+    {
+        dropped++;
+        return false;
+    }
+
+    frame.type = data[0];
+    frame.sequence = data[1];
+    frame.length = decoded - 4;
+    memcpy(frame.payload, data + 2, frame.length);
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <Arduino.h>
+
+// Framing of the supervisory link (SupervisoryLink.h), shared by the firmware
+// and the host tools. A frame is
+//
+//   0x00, COBS(type, sequence, payload..., CRC low, CRC high), 0x00
+//
+// COBS removes every zero byte from the frame, so a zero always marks a frame
+// boundary and a receiver that lost track resynchronises at the next one.
+// Text printed to Serial between frames contains no zeros either and ends up
+// as a separate chunk that fails to decode. The CRC is CRC-16/CCITT-FALSE over
+// type, sequence and payload.
+
+const uint8_t FRAME_DELIMITER = 0x00;
+const size_t MAX_FRAME_PAYLOAD = 96;
+const size_t MAX_FRAME_DATA = MAX_FRAME_PAYLOAD + 4;                 // Type, sequence and CRC
+const size_t MAX_ENCODED_FRAME = MAX_FRAME_DATA + MAX_FRAME_DATA / 254 + 3; // COBS overhead and both delimiters
+
+struct Frame
+{
+    uint8_t type;
+    uint8_t sequence;
+    uint8_t length; // Payload bytes
+    uint8_t payload[MAX_FRAME_PAYLOAD];
+};
+
+uint16_t crc16(const uint8_t *data, size_t length);
+
+// COBS without the delimiter. Returns the encoded length; out needs length + length / 254 + 1 bytes.
+size_t cobsEncode(const uint8_t *data, size_t length, uint8_t *out);
+
+// Returns the decoded length, 0 if the input is not valid COBS or does not fit into size.
+size_t cobsDecode(const uint8_t *data, size_t length, uint8_t *out, size_t size);
+
+// Encodes a frame with both delimiters into out (MAX_ENCODED_FRAME bytes). Returns its length.
+size_t encodeFrame(const Frame &frame, uint8_t *out);
+
+// Collects received bytes until a frame is complete.
+class FrameReader
+{
+public:
+    FrameReader() : used(0), overflow(false) {}
+
+    // Returns true when the byte completed a valid frame, which is then in frame.
+    // Chunks that fail to decode or whose CRC is wrong are dropped.
+    bool feed(uint8_t c, Frame &frame);
+
+    // Chunks dropped so far, for diagnostics.
+    unsigned long dropped = 0;
+
+private:
+    uint8_t buffer[MAX_ENCODED_FRAME];
+    size_t used;
+    bool overflow;
+};
+
+// Little-endian fields in payloads
+inline void putUint16(uint8_t *out, uint16_t value)
+{
+    out[0] = value;
+    out[1] = value >> 8;
+}
+
+inline void putUint32(uint8_t *out, uint32_t value)
+{
+    for (uint8_t i = 0; i < 4; i++)
+        out[i] = value >> (8 * i);
+}
+
+inline uint16_t getUint16(const uint8_t *in)
+{
+    return in[0] | (in[1] << 8);
+}
+
+inline uint32_t getUint32(const uint8_t *in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+#endif // FRAME_CODEC_H
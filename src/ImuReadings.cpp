@@ -0,0 +1,95 @@
+#include "ImuReadings.h"
+
+// 0.01 g per count = 400 / 32768 = 25 / 2^11
+const int32_t ACCELERATION_FACTOR = 25;
+const uint8_t ACCELERATION_SHIFT = 11;
+
+// 0.01 dps per count = 200000 / 32768 = 6250 / 2^10
+const int32_t ROTATION_FACTOR = 6250;
+const uint8_t ROTATION_SHIFT = 10;
+
+static int32_t scaleCounts(int16_t counts, int32_t factor, uint8_t shift)
+{
+    // 32768 * 6250 still fits into 31 bits
+    int32_t magnitude = counts < 0 ? -(int32_t)counts : counts;
+    int32_t scaled = (magnitude * factor + (1L << (shift - 1))) >> shift;
+    return counts < 0 ? -scaled : scaled;
+}
+
+int32_t accelerationCentiG(int16_t counts)
+{
+    return scaleCounts(counts, ACCELERATION_FACTOR, ACCELERATION_SHIFT);
+}
+
+int32_t rotationCentiDps(int16_t counts)
+{
+    return scaleCounts(counts, ROTATION_FACTOR, ROTATION_SHIFT);
+}
+
+#ifdef ARDUINO_ARCH_SAMD
+
+#include <Wire.h>
+
+// Same bus and address as the IMU object of Arduino_LSM6DS3
+const uint8_t LSM6DS3_ADDRESS = 0x6A;
+const uint8_t LSM6DS3_OUTX_L_G = 0x22;
+const uint8_t LSM6DS3_OUTX_L_XL = 0x28;
+
+// X, Y and Z follow each other as little-endian int16_t
+static bool readVector(uint8_t firstRegister, ImuCounts &counts)
+{
+    Wire.beginTransmission(LSM6DS3_ADDRESS);
+    Wire.write(firstRegister);
+    if (Wire.endTransmission(false) != 0)
+        return false;
+    if (Wire.requestFrom(LSM6DS3_ADDRESS, (uint8_t)6) != 6)
+        return false;
+
+    uint8_t data[6];
+    for (uint8_t i = 0; i < 6; i++)
+        data[i] = Wire.read();
+    counts.x = (int16_t)(data[0] | (data[1] << 8));
+    counts.y = (int16_t)(data[2] | (data[3] << 8));
+    counts.z = (int16_t)(data[4] | (data[5] << 8));
+    return true;
+}
+
+bool readRawAcceleration(ImuCounts &counts)
+{
+    return readVector(LSM6DS3_OUTX_L_XL, counts);
+}
+
+bool readRawGyroscope(ImuCounts &counts)
+{
+    return readVector(LSM6DS3_OUTX_L_G, counts);
+}
+
+#else
+
+#include <Arduino_LSM6DS3.h>
+
+// Host: the stand-in IMU only has the float API, turn its readings back into counts
+static int16_t toCounts(float value, uint16_t range)
+{
+    return (int16_t)(value * 32768.0F / range);
+}
+
+bool readRawAcceleration(ImuCounts &counts)
+{
+    float x, y, z;
+    if (!IMU.readAcceleration(x, y, z))
+        return false;
+    counts = {toCounts(x, ACCELERATION_RANGE_G), toCounts(y, ACCELERATION_RANGE_G), toCounts(z, ACCELERATION_RANGE_G)};
+    return true;
+}
+
+bool readRawGyroscope(ImuCounts &counts)
+{
+    float x, y, z;
+    if (!IMU.readGyroscope(x, y, z))
+        return false;
+    counts = {toCounts(x, ROTATION_RANGE_DPS), toCounts(y, ROTATION_RANGE_DPS), toCounts(z, ROTATION_RANGE_DPS)};
+    return true;
+}
+
+#endif // ARDUINO_ARCH_SAMD
@@ -0,0 +1,30 @@
+#ifndef IMU_READINGS_H
+#define IMU_READINGS_H
+
+#include <Arduino.h>
+
+// LSM6DS3 readings as raw counts and scaled integers, without the float API of
+// Arduino_LSM6DS3 (the Cortex-M0+ has no FPU, every float operation is a
+// library call). IMU.begin() still sets the sensor up; the scales below are
+// the ranges it configures.
+
+const uint16_t IMU_SAMPLE_RATE_HZ = 104;
+const uint16_t ACCELERATION_RANGE_G = 4;  // +-4 g over the full int16_t range
+const uint16_t ROTATION_RANGE_DPS = 2000; // +-2000 dps over the full int16_t range
+
+struct ImuCounts
+{
+    int16_t x, y, z;
+};
+
+// Read the output registers. False if the sensor does not answer.
+bool readRawAcceleration(ImuCounts &counts);
+bool readRawGyroscope(ImuCounts &counts);
+
+// Counts to hundredths of a g or of a degree per second, rounded half away
+// from zero. Print::print(float, 2) gave the same digits except for "-0.00"
+// and some exact halves (see src/host/json_format_main.cpp).
+int32_t accelerationCentiG(int16_t counts);
+int32_t rotationCentiDps(int16_t counts);
+
+#endif // IMU_READINGS_H
@@ -0,0 +1,165 @@
+#include "InputRecorder.h"
+#include "JunctionConfig.h"
+#include "LampDriver.h"
+
+static RecordedEvent events[RECORDER_CAPACITY];
+static size_t eventCount = 0;
+static bool recording = false;
+static bool overflowed = false;
+static TrafficControllerSnapshot snapshot;
+static EventListener listener = NULL;
+
+void startRecording()
+{
+    eventCount = 0;
+    overflowed = false;
+    getTrafficControllerSnapshot(snapshot);
+    recording = true;
+}
+
+void stopRecording()
+{
+    recording = false;
+}
+
+bool isRecording()
+{
+    return recording;
+}
+
+bool recordingOverflowed()
+{
+    return overflowed;
+}
+
+void setEventListener(EventListener newListener)
+{
+    listener = newListener;
+}
+
+void recordEvent(RecordedEventType type, uint8_t arg, unsigned long time)
+{
+    if (!recording && !listener)
+        return;
+
+    RecordedEvent event;
+    event.time = time;
+    event.type = type;
+    event.arg = arg;
+    event.lamps = sampleLampOutputs();
+    if (listener)
+        listener(event);
+    if (!recording)
+        return;
+
+    // A replay cannot skip inputs, so stop at the first one that does not fit
+    if (eventCount >= RECORDER_CAPACITY)
+    {
+        overflowed = true;
+        recording = false;
+        return;
+    }
+
+    events[eventCount++] = event;
+}
+
+size_t recordedEventCount()
+{
+    return eventCount;
+}
+
+const RecordedEvent &recordedEvent(size_t index)
+{
+    return events[index];
+}
+
+const TrafficControllerSnapshot &recordingSnapshot()
+{
+    return snapshot;
+}
+
+uint32_t sampleLampOutputs()
+{
+    uint32_t mask = 0;
+    uint8_t bit = 0;
+    for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
+    {
+        const int pins[] = {SIGNAL_GROUPS[i].red, SIGNAL_GROUPS[i].yellow, SIGNAL_GROUPS[i].green};
+        for (uint8_t j = 0; j < 3 && bit < 32; j++)
+        {
+            if (pins[j] == NO_PIN)
+                continue;
+            if (readLamp(pins[j]))
+                mask |= 1UL << bit;
+            bit++;
+        }
+    }
+    return mask;
+}
+
+// Format:
+//   # capture v6
+//   S,<time>,<state>,<sequenceStep>,<pedestrianFlag>,<vehicleFlag>,<activePlan>,<pendingPlan>,<stateStartTime>,<preemptTarget>,<preemptTime>
+//   C,<custom plan mode>,<duration>,...       (one duration per phase)
+//   E,<time>,<type>,<arg>,<lamps in hex>      (one line per event)
+//   # end <count> [overflow]
+void printRecordingHeader(Print &out)
+{
+    out.println("# capture v6");
+    out.print("S,");
+    out.print((unsigned long)snapshot.time);
+    out.print(",");
+    out.print(snapshot.state);
+    out.print(",");
+    out.print(snapshot.sequenceStep);
+    out.print(",");
+    out.print(snapshot.pedestrianFlag ? 1 : 0);
+    out.print(",");
+    out.print(snapshot.vehicleFlag ? 1 : 0);
+    out.print(",");
+    out.print(snapshot.activePlan);
+    out.print(",");
+    out.print(snapshot.pendingPlan);
+    out.print(",");
+    out.print((unsigned long)snapshot.stateStartTime);
+    out.print(",");
+    out.print(snapshot.preemptTarget);
+    out.print(",");
+    out.println((unsigned long)snapshot.preemptTime);
+    out.print("C,");
+    out.print(snapshot.customMode);
+    for (uint8_t i = 0; i < PHASE_COUNT; i++)
+    {
+        out.print(",");
+        out.print((unsigned long)snapshot.customDurations[i]);
+    }
+    out.println();
+}
+
+void printRecordedEvent(Print &out, size_t index)
+{
+    out.print("E,");
+    out.print((unsigned long)events[index].time);
+    out.print(",");
+    out.print(events[index].type);
+    out.print(",");
+    out.print(events[index].arg);
+    out.print(",");
+    out.println((unsigned long)events[index].lamps, HEX);
+}
+
+void printRecordingFooter(Print &out, size_t count)
+{
+    out.print("# end ");
+    out.print((unsigned long)count);
+    out.println(overflowed ? " overflow" : "");
+}
+
+void printRecording(Print &out)
+{
+    size_t count = eventCount;
+    printRecordingHeader(out);
+    for (size_t i = 0; i < count; i++)
+        printRecordedEvent(out, i);
+    printRecordingFooter(out, count);
+}
@@ -0,0 +1,69 @@
+#ifndef INPUT_RECORDER_H
+#define INPUT_RECORDER_H
+
+#include <Arduino.h>
+#include "TrafficLightController.h"
+
+// Capture of every input to the traffic light controller, so that an incident
+// can be downloaded from /capture and replayed on the host (env:replay).
+// The replay starts from the snapshot taken by startRecording() and feeds the
+// events back at their recorded millis(), then compares the lamp outputs.
+
+enum RecordedEventType : uint8_t
+{
+    EVENT_PEDESTRIAN_BUTTON, // Pedestrian button press was accepted
+    EVENT_VEHICLE_SENSOR,    // Vehicle detection was accepted
+    EVENT_WEB_SET,           // /set command, arg = new state
+    EVENT_TICK,              // updateTrafficController() pass that changed the lamps, arg = state
+    EVENT_PLAN,              // Timing plan requested by the scheduler, arg = plan
+    EVENT_LAMP_FALLBACK,     // Controller took over from the blink timer fallback, arg = state
+    EVENT_PREEMPT,           // Preemption requested, arg = target phase
+    EVENT_PREEMPT_RELEASE    // Preemption released
+};
+
+// One captured input
+struct RecordedEvent
+{
+    uint32_t time;  // millis() when the input arrived
+    uint8_t type;   // RecordedEventType
+    uint8_t arg;    // Event specific argument
+    uint32_t lamps; // Lamp outputs after the input was handled, see sampleLampOutputs()
+};
+
+const size_t RECORDER_CAPACITY = 256;
+
+// Clears the buffer, takes a controller snapshot and starts recording.
+void startRecording();
+void stopRecording();
+bool isRecording();
+
+// True if events were dropped because the buffer was full.
+bool recordingOverflowed();
+
+// Called by the controller for each input it accepts. Does nothing unless
+// recording or a listener is set.
+void recordEvent(RecordedEventType type, uint8_t arg, unsigned long time);
+
+// Gets every input as it is handled, whether recording or not (used by the
+// supervisory link to stream them). NULL removes the listener.
+typedef void (*EventListener)(const RecordedEvent &event);
+void setEventListener(EventListener listener);
+
+size_t recordedEventCount();
+const RecordedEvent &recordedEvent(size_t index);
+const TrafficControllerSnapshot &recordingSnapshot();
+
+// Reads back the lamp outputs into a bit mask (blinking lamps count as on): red, yellow, green of each
+// signal group in SIGNAL_GROUPS order, lamps without a pin are skipped.
+uint32_t sampleLampOutputs();
+
+// Writes the capture in the text format read by the host replay.
+void printRecording(Print &out);
+
+// The same output in pieces, for sending it over several loop passes: the
+// header, then events 0 to count - 1, then the footer with that count.
+void printRecordingHeader(Print &out);
+void printRecordedEvent(Print &out, size_t index);
+void printRecordingFooter(Print &out, size_t count);
+
+#endif // INPUT_RECORDER_H
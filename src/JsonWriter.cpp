@@ -0,0 +1,168 @@
+#include "JsonWriter.h"
+
+JsonWriter::JsonWriter(char *buffer, size_t size)
+    : buffer(buffer), size(size), used(0), overflow(size == 0), afterKey(false), depth(0), excessDepth(0), hasMembers(0)
+{
+    if (size > 0)
+        buffer[0] = '\0';
+}
+
+void JsonWriter::put(char c)
+{
+    if (used + 1 >= size)
+    {
+        overflow = true;
+        return;
+    }
+    buffer[used++] = c;
+    buffer[used] = '\0';
+}
+
+// Comma before every member but the first, nothing between a key and its value
+void JsonWriter::separate()
+{
+    if (afterKey)
+    {
+        afterKey = false;
+        return;
+    }
+    if (depth == 0 || excessDepth > 0)
+        return;
+    uint8_t bit = 1 << (depth - 1);
+    if (hasMembers & bit)
+        put(',');
+    hasMembers |= bit;
+}
+
+void JsonWriter::open(char bracket)
+{
+    separate();
+    put(bracket);
+    // Too deep: the output is marked broken and the level only counted, so
+    // that the outer levels carry on where they were once it is closed
+    if (depth == MAX_DEPTH)
+    {
+        overflow = true;
+        excessDepth++;
+        return;
+    }
+    depth++;
+    hasMembers &= ~(1 << (depth - 1));
+}
+
+void JsonWriter::close(char bracket)
+{
+    if (excessDepth > 0)
+        excessDepth--;
+    else if (depth > 0)
+        depth--;
+    put(bracket);
+}
+
+void JsonWriter::beginObject()
+{
+    open('{');
+}
+
+void JsonWriter::endObject()
+{
+    close('}');
+}
+
+void JsonWriter::beginArray()
+{
+    open('[');
+}
+
+void JsonWriter::endArray()
+{
+    close(']');
+}
+
+void JsonWriter::putString(const char *text)
+{
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+
+    put('"');
+    for (const char *c = text; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            put('\\');
+            put(*c);
+        }
+        else if ((uint8_t)*c < 0x20)
+        {
+            put('\\');
+            put('u');
+            put('0');
+            put('0');
+            put(HEX_DIGITS[(uint8_t)*c >> 4]);
+            put(HEX_DIGITS[*c & 0x0F]);
+        }
+        else
+            put(*c);
+    }
+    put('"');
+}
+
+void JsonWriter::key(const char *name)
+{
+    separate();
+    putString(name);
+    put(':');
+    afterKey = true;
+}
+
+void JsonWriter::value(const char *text)
+{
+    separate();
+    putString(text);
+}
+
+void JsonWriter::boolean(bool flag)
+{
+    separate();
+    const char *text = flag ? "true" : "false";
+    while (*text)
+        put(*text++);
+}
+
+void JsonWriter::putUnsigned(uint32_t number, uint8_t minDigits)
+{
+    char digits[10];
+    uint8_t count = 0;
+    do
+    {
+        digits[count++] = '0' + number % 10;
+        number /= 10;
+    } while (number > 0 || count < minDigits);
+    while (count > 0)
+        put(digits[--count]);
+}
+
+void JsonWriter::value(int32_t number)
+{
+    fixed(number, 0);
+}
+
+void JsonWriter::fixed(int32_t scaled, uint8_t decimals)
+{
+    separate();
+    // Negate in unsigned arithmetic, INT32_MIN has no positive counterpart
+    uint32_t magnitude = scaled < 0 ? 0U - (uint32_t)scaled : (uint32_t)scaled;
+    if (scaled < 0)
+        put('-');
+    if (decimals > 9)
+        decimals = 9;
+
+    uint32_t divisor = 1;
+    for (uint8_t i = 0; i < decimals; i++)
+        divisor *= 10;
+    putUnsigned(magnitude / divisor, 1);
+    if (decimals > 0)
+    {
+        put('.');
+        putUnsigned(magnitude % divisor, decimals);
+    }
+}
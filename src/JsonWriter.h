@@ -0,0 +1,59 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <Arduino.h>
+
+// Writes JSON into a buffer of the caller, without heap, String or floats.
+// Commas are placed automatically; numbers with decimals are written from
+// scaled integers (fixed(1234, 2) writes 12.34). When the buffer is too small
+// the output is cut off and ok() turns false, the buffer always stays
+// terminated.
+//
+//   char body[48];
+//   JsonWriter json(body, sizeof(body));
+//   json.beginObject();
+//   json.key("x");
+//   json.fixed(-5, 2); // -0.05
+//   json.endObject();  // {"x":-0.05}
+
+class JsonWriter
+{
+public:
+    JsonWriter(char *buffer, size_t size);
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    void key(const char *name);
+    void value(const char *text);
+    void value(int32_t number);
+    void boolean(bool flag); // Not value(bool): value(5) would be ambiguous where int32_t is long
+    void fixed(int32_t scaled, uint8_t decimals);
+
+    const char *c_str() const { return buffer; }
+    size_t length() const { return used; }
+    bool ok() const { return !overflow; }
+
+private:
+    static const uint8_t MAX_DEPTH = 8;
+
+    void separate();
+    void open(char bracket);
+    void close(char bracket);
+    void put(char c);
+    void putString(const char *text);
+    void putUnsigned(uint32_t number, uint8_t minDigits);
+
+    char *buffer;
+    size_t size;
+    size_t used;
+    bool overflow;
+    bool afterKey;
+    uint8_t depth;
+    uint8_t excessDepth; // Levels opened beyond MAX_DEPTH, written without commas
+    uint8_t hasMembers;  // One bit per nesting level
+};
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,126 @@
+#include "JunctionConfig.h"
+#include "PinDefinitions.h"
+
+// T-junction: main road from left to right (Ampel 1 and 3), side road Ampel 2,
+// pedestrian crossing with heads on the poles of Ampel 1 and 2.
+
+enum SignalGroupIndex
+{
+    GROUP_LAMP1,
+    GROUP_LAMP2,
+    GROUP_LAMP3,
+    GROUP_PED1,
+    GROUP_PED2
+};
+
+const SignalGroup SIGNAL_GROUPS[] = {
+    {"Ampel 1", LAMP1_RED, LAMP1_YELLOW, LAMP1_GREEN, false},
+    {"Ampel 2", LAMP2_RED, LAMP2_YELLOW, LAMP2_GREEN, false},
+    {"Ampel 3", LAMP3_RED, LAMP3_YELLOW, LAMP3_GREEN, false},
+    {"Fußgänger 1", LAMP1_RED_PED, NO_PIN, LAMP1_GREEN_PED, true},
+    {"Fußgänger 2", LAMP2_RED_PED, NO_PIN, LAMP2_GREEN_PED, true}};
+
+constexpr uint8_t SIGNAL_GROUP_COUNT = sizeof(SIGNAL_GROUPS) / sizeof(SIGNAL_GROUPS[0]);
+static_assert(SIGNAL_GROUP_COUNT <= MAX_SIGNAL_GROUPS, "Raise MAX_SIGNAL_GROUPS in JunctionConfig.h");
+
+const unsigned long MAIN_GREEN_DURATION = 10000;       // 10 sec.
+const unsigned long MAIN_GREEN_DEMAND_DURATION = 5000; // 5 sec. while a vehicle waits on the side road
+const unsigned long MAIN_YELLOW_DURATION = 3000;       // 3 sec.
+const unsigned long ALL_RED_DURATION = 2000;           // 2 sec.
+const unsigned long SIDE_GREEN_DURATION = 5000;        // 5 sec.
+const unsigned long SIDE_YELLOW_DURATION = 3000;       // 3 sec.
+const unsigned long PEDESTRIAN_GREEN_DURATION = 10000; // 10 sec
+const unsigned long PEDESTRIAN_BLINK_DURATION = 3000;  // last 3 sec.
+
+#define R ASPECT_RED
+#define RY ASPECT_RED_YELLOW
+#define Y ASPECT_YELLOW
+#define G ASPECT_GREEN
+#define YF ASPECT_YELLOW_FLASHING
+#define D ASPECT_DARK
+
+// Indexed by TrafficLightState. Aspects: Ampel 1, Ampel 2, Ampel 3, Fußgänger 1, Fußgänger 2
+const Phase PHASES[] = {
+    {"MAIN_GREEN", MAIN_GREEN_DURATION, MAIN_GREEN_DEMAND_DURATION, 0, 0, NO_PHASE, {G, R, G, R, R}},
+    {"MAIN_YELLOW", MAIN_YELLOW_DURATION, 0, 0, 0, NO_PHASE, {Y, R, Y, R, R}},
+    {"ALL_RED", ALL_RED_DURATION, 0, 0, PHASE_CLEARANCE, NO_PHASE, {R, R, R, R, R}},
+    {"SIDE_RED_YELLOW", ALL_RED_DURATION, 0, 0, 0, NO_PHASE, {R, RY, R, R, R}},
+    {"SIDE_GREEN", SIDE_GREEN_DURATION, 0, 0, PHASE_SERVES_VEHICLE, NO_PHASE, {R, G, R, R, R}},
+    {"SIDE_YELLOW", SIDE_YELLOW_DURATION, 0, 0, 0, NO_PHASE, {R, Y, R, R, R}},
+    {"MAIN_RED_YELLOW", ALL_RED_DURATION, 0, 0, 0, NO_PHASE, {RY, R, RY, R, R}},
+    {"PEDESTRIAN_GREEN", PEDESTRIAN_GREEN_DURATION, 0, PEDESTRIAN_BLINK_DURATION, PHASE_SERVES_PEDESTRIAN, ALL_RED, {R, R, R, G, G}},
+    {"FLASHING_YELLOW", 0, 0, 0, PHASE_FLASHING, ALL_RED, {YF, YF, YF, D, D}}};
+
+#undef R
+#undef RY
+#undef Y
+#undef G
+#undef YF
+#undef D
+
+// Sizes the per-phase arrays, e.g. TimingPlan::durations and those in PhaseGraph.cpp
+constexpr uint8_t PHASE_COUNT = sizeof(PHASES) / sizeof(PHASES[0]);
+static_assert(PHASE_COUNT <= MAX_PHASES, "Raise MAX_PHASES in JunctionConfig.h");
+
+const uint8_t PHASE_SEQUENCE[] = {
+    MAIN_GREEN,
+    MAIN_YELLOW,
+    ALL_RED,
+    SIDE_RED_YELLOW,
+    SIDE_GREEN,
+    SIDE_YELLOW,
+    ALL_RED,
+    MAIN_RED_YELLOW};
+
+constexpr uint8_t PHASE_SEQUENCE_LENGTH = sizeof(PHASE_SEQUENCE) / sizeof(PHASE_SEQUENCE[0]);
+
+const uint8_t PEDESTRIAN_PHASE = PEDESTRIAN_GREEN;
+
+const uint8_t VEHICLE_FEEDBACK_GROUP = GROUP_LAMP2;
+
+const uint8_t FLASHING_PHASE = FLASHING_YELLOW;
+
+// Emergency vehicles come along the main road
+const uint8_t PREEMPTION_PHASE = MAIN_GREEN;
+
+const unsigned long PREEMPTION_TIMEOUT = 120000; // 2 min.
+
+const unsigned long MINIMUM_GREEN = 5000; // 5 sec.
+
+// --- Timing plans ---
+
+enum TimingPlanIndex
+{
+    PLAN_DAY,
+    PLAN_PEAK,
+    PLAN_QUIET,
+    PLAN_NIGHT
+};
+
+// Durations in PHASES[] order, 0 keeps the default
+const TimingPlan TIMING_PLANS[] = {
+    {"DAY", PLAN_CYCLE, {0}},
+    {"PEAK", PLAN_CYCLE, {20000, 0, 0, 0, 8000}},  // Longer greens for rush hour
+    {"QUIET", PLAN_REST_IN_GREEN, {0}},            // Main road stays green until someone waits
+    {"NIGHT", PLAN_FLASHING, {0}}};                // Flashing yellow
+
+constexpr uint8_t TIMING_PLAN_COUNT = sizeof(TIMING_PLANS) / sizeof(TIMING_PLANS[0]);
+static_assert(TIMING_PLAN_COUNT < CUSTOM_TIMING_PLAN, "Too many timing plans");
+
+const unsigned long MAXIMUM_PHASE_DURATION = 120000; // 2 min.
+
+const uint8_t DEFAULT_TIMING_PLAN = PLAN_DAY;
+
+const ScheduleEntry WEEKLY_SCHEDULE[] = {
+    {EVERY_DAY, 0 * 60, PLAN_NIGHT},
+    {WEEKDAYS, 5 * 60, PLAN_QUIET},
+    {WEEKDAYS, 6 * 60 + 30, PLAN_DAY},
+    {WEEKDAYS, 7 * 60, PLAN_PEAK},
+    {WEEKDAYS, 9 * 60, PLAN_DAY},
+    {WEEKDAYS, 16 * 60, PLAN_PEAK},
+    {WEEKDAYS, 18 * 60 + 30, PLAN_DAY},
+    {WEEKEND, 7 * 60, PLAN_QUIET},
+    {WEEKEND, 10 * 60, PLAN_DAY},
+    {EVERY_DAY, 21 * 60, PLAN_QUIET}};
+
+constexpr uint8_t WEEKLY_SCHEDULE_LENGTH = sizeof(WEEKLY_SCHEDULE) / sizeof(WEEKLY_SCHEDULE[0]);
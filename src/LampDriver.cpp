@@ -0,0 +1,344 @@
+#include "LampDriver.h"
+
+// --- Blinking ---
+// Lamps are pin numbers or register outputs, both below 32, so sets of lamps are bit masks.
+
+const uint8_t BLINK_RATE_COUNT = 3;
+static const uint8_t BLINK_HALF_PERIOD_TICKS[BLINK_RATE_COUNT] = {0, 250 / BLINK_TICK_MS, 500 / BLINK_TICK_MS};
+
+static volatile uint32_t blinkingLamps[BLINK_RATE_COUNT]; // Lamps per BlinkRate
+static volatile uint8_t blinkTicks[BLINK_RATE_COUNT];     // Ticks into the current half period
+static volatile uint32_t darkLamps;                       // Blinking lamps in their dark half period
+
+static uint32_t lampBit(int lamp)
+{
+    return lamp >= 0 && lamp < 32 ? 1UL << lamp : 0;
+}
+
+static void resetBlinking()
+{
+    for (uint8_t rate = 0; rate < BLINK_RATE_COUNT; rate++)
+    {
+        blinkingLamps[rate] = 0;
+        blinkTicks[rate] = 0;
+    }
+    darkLamps = 0;
+}
+
+// Backend: setLampBlink() changed how the lamps are shown
+static void blinkChanged(uint32_t lamps);
+// Backend: the blink timer toggled the lamps
+static void blinkToggled(uint32_t lamps);
+
+#if LAMP_DRIVER == LAMP_DRIVER_DIRECT
+
+// Written level per pin
+static volatile uint32_t lampLevels = 0;
+
+static void showPins(uint32_t lamps)
+{
+    for (uint8_t pin = 0; pin < 32; pin++)
+    {
+        if (lamps & (1UL << pin))
+            digitalWrite(pin, (lampLevels & ~darkLamps & (1UL << pin)) ? HIGH : LOW);
+    }
+}
+
+static void blinkChanged(uint32_t lamps)
+{
+    showPins(lamps);
+}
+
+static void blinkToggled(uint32_t lamps)
+{
+    showPins(lamps);
+}
+
+static void setupPin(int pin)
+{
+    if (pin == NO_PIN)
+        return;
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, LOW);
+}
+
+void initLampDriver()
+{
+    resetBlinking();
+    lampLevels = 0;
+    for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
+    {
+        setupPin(SIGNAL_GROUPS[i].red);
+        setupPin(SIGNAL_GROUPS[i].yellow);
+        setupPin(SIGNAL_GROUPS[i].green);
+    }
+}
+
+void writeLamp(int lamp, bool on)
+{
+    uint32_t bit = lampBit(lamp);
+    if (!bit)
+        return;
+
+    // The blink timer writes the same pins
+    noInterrupts();
+    lampLevels = on ? (lampLevels | bit) : (lampLevels & ~bit);
+    showPins(bit);
+    interrupts();
+}
+
+bool readLamp(int lamp)
+{
+    return lampLevels & lampBit(lamp);
+}
+
+void latchLamps()
+{
+}
+
+#elif LAMP_DRIVER == LAMP_DRIVER_SHIFT_REGISTER
+
+// The blink masks have one bit per output
+static_assert(SHIFT_REGISTER_COUNT <= 4, "Blinking only covers the outputs of 4 shift registers");
+
+// One bit per output, register 0 (the one connected to MOSI) first.
+// Writes go to lampImage, latchLamps() copies it to latchedImage, which is
+// what the blink timer sends when it toggles lamps.
+static uint8_t lampImage[SHIFT_REGISTER_COUNT];
+static uint8_t latchedImage[SHIFT_REGISTER_COUNT];
+static bool imageChanged = true;
+
+static uint8_t darkOutputs(uint8_t reg)
+{
+    return darkLamps >> (reg * 8);
+}
+
+// The byte for the last register of the chain has to be shifted out first
+static void buildFrame(uint8_t *frame)
+{
+    for (uint8_t i = 0; i < SHIFT_REGISTER_COUNT; i++)
+    {
+        uint8_t reg = SHIFT_REGISTER_COUNT - 1 - i;
+        frame[i] = latchedImage[reg] & ~darkOutputs(reg);
+    }
+}
+
+static void sendFrame();
+
+static void blinkChanged(uint32_t)
+{
+    imageChanged = true;
+}
+
+static void blinkToggled(uint32_t)
+{
+    sendFrame();
+}
+
+#ifdef ARDUINO_ARCH_SAMD
+
+#include <SPI.h>
+
+// SPI is on SERCOM1 on the Nano 33 IoT
+const uint8_t LAMP_DMA_CHANNEL = 0;
+const uint32_t SHIFT_REGISTER_CLOCK = 4000000; // 4 MHz, well within the 74HC595 at 3.3 V
+
+__attribute__((aligned(16))) static DmacDescriptor dmaDescriptors[LAMP_DMA_CHANNEL + 1];
+__attribute__((aligned(16))) static DmacDescriptor dmaWriteback[LAMP_DMA_CHANNEL + 1];
+static uint8_t dmaFrame[SHIFT_REGISTER_COUNT];
+static volatile bool transferBusy = false;
+
+static void initTransport()
+{
+    pinMode(SHIFT_REGISTER_LATCH, OUTPUT);
+    digitalWrite(SHIFT_REGISTER_LATCH, LOW);
+
+    // The chain is the only device on this SPI port, so the transaction stays open
+    SPI.begin();
+    SPI.beginTransaction(SPISettings(SHIFT_REGISTER_CLOCK, MSBFIRST, SPI_MODE0));
+
+    PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+    PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+    DMAC->CTRL.reg &= ~DMAC_CTRL_DMAENABLE;
+    DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+    DMAC->BASEADDR.reg = (uint32_t)dmaDescriptors;
+    DMAC->WRBADDR.reg = (uint32_t)dmaWriteback;
+    DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xf);
+
+    // One byte per SERCOM TX request, interrupt when the frame is written
+    DMAC->CHID.reg = DMAC_CHID_ID(LAMP_DMA_CHANNEL);
+    DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+    DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) | DMAC_CHCTRLB_TRIGSRC(SERCOM1_DMAC_ID_TX) | DMAC_CHCTRLB_TRIGACT_BEAT;
+    DMAC->CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;
+    NVIC_EnableIRQ(DMAC_IRQn);
+}
+
+static void sendFrame()
+{
+    // A frame is a few microseconds on the wire, the previous one is done long before.
+    // The blink timer also sends frames, so wait with interrupts off but let them
+    // in between checks for the DMAC handler to finish the previous frame.
+    noInterrupts();
+    while (transferBusy)
+    {
+        interrupts();
+        noInterrupts();
+    }
+
+    buildFrame(dmaFrame);
+    DmacDescriptor &descriptor = dmaDescriptors[LAMP_DMA_CHANNEL];
+    descriptor.BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_BLOCKACT_NOACT;
+    descriptor.BTCNT.reg = SHIFT_REGISTER_COUNT;
+    descriptor.SRCADDR.reg = (uint32_t)(dmaFrame + SHIFT_REGISTER_COUNT); // End address when incrementing
+    descriptor.DSTADDR.reg = (uint32_t)&SERCOM1->SPI.DATA.reg;
+    descriptor.DESCADDR.reg = 0;
+
+    transferBusy = true;
+    DMAC->CHID.reg = DMAC_CHID_ID(LAMP_DMA_CHANNEL);
+    DMAC->CHCTRLA.reg |= DMAC_CHCTRLA_ENABLE;
+    interrupts();
+}
+
+extern "C" void DMAC_Handler()
+{
+    DMAC->CHID.reg = DMAC_CHID_ID(LAMP_DMA_CHANNEL);
+    DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+
+    // The last byte was only handed to the SERCOM, latch once it is shifted out
+    while (!SERCOM1->SPI.INTFLAG.bit.TXC)
+        ;
+    digitalWrite(SHIFT_REGISTER_LATCH, HIGH);
+    digitalWrite(SHIFT_REGISTER_LATCH, LOW);
+    transferBusy = false;
+}
+
+#else
+
+// Host mock: keeps the frames instead of sending them
+static uint8_t lastFrame[SHIFT_REGISTER_COUNT];
+static size_t frameCount = 0;
+
+static void initTransport()
+{
+    frameCount = 0;
+}
+
+static void sendFrame()
+{
+    buildFrame(lastFrame);
+    frameCount++;
+}
+
+size_t hostLampFrameCount()
+{
+    return frameCount;
+}
+
+const uint8_t *hostLastLampFrame()
+{
+    return lastFrame;
+}
+
+#endif // ARDUINO_ARCH_SAMD
+
+void initLampDriver()
+{
+    initTransport();
+    resetBlinking();
+    memset(lampImage, 0, sizeof(lampImage));
+    imageChanged = true;
+    latchLamps();
+}
+
+void writeLamp(int lamp, bool on)
+{
+    if (lamp == NO_PIN || lamp >= SHIFT_REGISTER_COUNT * 8)
+        return;
+
+    uint8_t &reg = lampImage[lamp / 8];
+    uint8_t mask = 1 << (lamp % 8);
+    noInterrupts();
+    uint8_t value = on ? (reg | mask) : (reg & ~mask);
+    if (value != reg)
+    {
+        reg = value;
+        imageChanged = true;
+    }
+    interrupts();
+}
+
+bool readLamp(int lamp)
+{
+    if (lamp == NO_PIN || lamp >= SHIFT_REGISTER_COUNT * 8)
+        return false;
+    return lampImage[lamp / 8] & (1 << (lamp % 8));
+}
+
+void latchLamps()
+{
+    noInterrupts();
+    bool changed = imageChanged;
+    imageChanged = false;
+    memcpy(latchedImage, lampImage, sizeof(lampImage));
+    interrupts();
+
+    if (changed)
+        sendFrame();
+}
+
+#endif // LAMP_DRIVER
+
+void setLampBlink(int lamp, BlinkRate rate)
+{
+    uint32_t bit = lampBit(lamp);
+    if (!bit || (rate != BLINK_NONE && (blinkingLamps[rate] & bit)))
+        return;
+
+    noInterrupts();
+    bool wasBlinking = false;
+    for (uint8_t other = BLINK_FAST; other < BLINK_RATE_COUNT; other++)
+    {
+        wasBlinking = wasBlinking || (blinkingLamps[other] & bit);
+        blinkingLamps[other] &= ~bit;
+    }
+    darkLamps &= ~bit;
+    if (rate != BLINK_NONE)
+    {
+        // All lamps of a rate share its phase
+        if (!blinkingLamps[rate])
+            blinkTicks[rate] = 0;
+        else if (darkLamps & blinkingLamps[rate])
+            darkLamps |= bit;
+        blinkingLamps[rate] |= bit;
+    }
+    interrupts();
+
+    if (wasBlinking || rate != BLINK_NONE)
+        blinkChanged(bit);
+}
+
+void advanceLampBlink()
+{
+    uint32_t toggled = 0;
+    for (uint8_t rate = BLINK_FAST; rate < BLINK_RATE_COUNT; rate++)
+    {
+        uint32_t lamps = blinkingLamps[rate];
+        if (!lamps || ++blinkTicks[rate] < BLINK_HALF_PERIOD_TICKS[rate])
+            continue;
+        blinkTicks[rate] = 0;
+        darkLamps ^= lamps;
+        toggled |= lamps;
+    }
+    if (toggled)
+        blinkToggled(toggled);
+}
+
+void showAspect(const SignalGroup &group, uint8_t aspect)
+{
+    writeLamp(group.red, aspect == ASPECT_RED || aspect == ASPECT_RED_YELLOW);
+    writeLamp(group.yellow, aspect == ASPECT_YELLOW || aspect == ASPECT_RED_YELLOW || aspect == ASPECT_YELLOW_FLASHING);
+    writeLamp(group.green, aspect == ASPECT_GREEN);
+    setLampBlink(group.yellow, aspect == ASPECT_YELLOW_FLASHING ? BLINK_SLOW : BLINK_NONE);
+    setLampBlink(group.green, BLINK_NONE);
+}
@@ -0,0 +1,57 @@
+#ifndef LAMP_DRIVER_H
+#define LAMP_DRIVER_H
+
+#include <Arduino.h>
+#include "PinDefinitions.h"
+#include "JunctionConfig.h"
+
+// Lamp outputs of all signal groups, independent of how they are wired.
+//
+// LAMP_DRIVER_DIRECT: every lamp is an Arduino pin, writes take effect at once.
+// LAMP_DRIVER_SHIFT_REGISTER: lamps are outputs of chained 74HC595 registers.
+// Writes only change an image in RAM; latchLamps() sends the whole image in
+// one DMA transfer over SPI and pulses the latch when the last bit is out, so
+// all heads switch at the same instant.
+//
+// Blinking is done here as well, driven by the blink timer (BlinkTimer.h): a
+// lamp set to blink follows the on/off phase of its rate while it is switched
+// on, whatever the caller is doing. readLamp() returns the level that was
+// written, not the blink phase.
+
+// Sets up the outputs of every lamp in SIGNAL_GROUPS and switches them off.
+void initLampDriver();
+
+void writeLamp(int lamp, bool on);
+bool readLamp(int lamp);
+
+// Makes the written lamps visible. Call after each group of writes that belongs together.
+void latchLamps();
+
+enum BlinkRate : uint8_t
+{
+    BLINK_NONE,
+    BLINK_FAST, // 2 Hz, pedestrian greens at the end of their phase
+    BLINK_SLOW  // 1 Hz, flashing yellow
+};
+
+const unsigned long BLINK_TICK_MS = 10; // Period of advanceLampBlink() calls
+
+// Starts or stops blinking a lamp. A rate that had no lamps starts with a lit
+// half period, a lamp joining a running rate takes over its phase.
+void setLampBlink(int lamp, BlinkRate rate);
+
+// Called by the blink timer every BLINK_TICK_MS, from its interrupt on the board.
+void advanceLampBlink();
+
+// Writes the lamps of a signal group for an aspect, including the blinking of
+// flashing yellow. Also stops the green from blinking.
+void showAspect(const SignalGroup &group, uint8_t aspect);
+
+#if LAMP_DRIVER == LAMP_DRIVER_SHIFT_REGISTER && !defined(ARDUINO_ARCH_SAMD)
+// Host mock of the SPI/DMA transfer: number of frames latched so far and the
+// last one, in the byte order it was shifted out (last register first).
+size_t hostLampFrameCount();
+const uint8_t *hostLastLampFrame();
+#endif
+
+#endif // LAMP_DRIVER_H
@@ -0,0 +1,179 @@
+#include "MemoryMonitor.h"
+
+const unsigned long MEMORY_SAMPLE_INTERVAL = 1000;  // 1 sec.
+const unsigned long MEMORY_REPORT_INTERVAL = 60000; // 1 min.
+
+static MemoryStats stats;
+static unsigned long lastSample = 0;
+static unsigned long lastReport = 0;
+static volatile unsigned long allocationCount = 0;
+static unsigned long steadyStateBaseline = 0;
+
+#ifdef COUNT_HEAP_ALLOCATIONS
+// With -Wl,--wrap every malloc(), calloc() and realloc() call of the firmware
+// and its libraries (String and operator new included) comes through here.
+// newlib itself allocates through _malloc_r() and friends (stdio buffers,
+// strdup()), which are not counted: wrapping them as well would count every
+// malloc() twice, since newlib's malloc() calls _malloc_r().
+extern "C" void *__real_malloc(size_t size);
+extern "C" void *__real_calloc(size_t count, size_t size);
+extern "C" void *__real_realloc(void *ptr, size_t size);
+
+extern "C" void *__wrap_malloc(size_t size)
+{
+    allocationCount++;
+    return __real_malloc(size);
+}
+
+extern "C" void *__wrap_calloc(size_t count, size_t size)
+{
+    allocationCount++;
+    return __real_calloc(count, size);
+}
+
+extern "C" void *__wrap_realloc(void *ptr, size_t size)
+{
+    allocationCount++;
+    return __real_realloc(ptr, size);
+}
+#endif
+
+#ifdef ARDUINO_ARCH_SAMD
+
+extern "C" char *sbrk(int increment);
+extern "C" char __StackTop; // Top of RAM, the stack grows down from here
+extern "C" char end;        // End of .bss, the heap grows up from here
+
+// newlib-nano keeps freed chunks in a list, the size includes the chunk header
+struct FreeChunk
+{
+    long size;
+    FreeChunk *next;
+};
+extern "C" FreeChunk *__malloc_free_list;
+
+const uint32_t STACK_PAINT = 0xA5A5A5A5;
+const size_t STACK_PAINT_MARGIN = 256; // Left alone below the stack pointer for interrupts
+
+static uint32_t *alignUp(char *address)
+{
+    return (uint32_t *)(((uintptr_t)address + 3) & ~(uintptr_t)3);
+}
+
+void initMemoryMonitor()
+{
+    uint32_t *word = alignUp(sbrk(0));
+    uint32_t *limit = (uint32_t *)(__get_MSP() - STACK_PAINT_MARGIN);
+    while (word < limit)
+        *word++ = STACK_PAINT;
+
+    stats.minFreeHeap = (size_t)-1;
+    stats.minLargestBlock = (size_t)-1;
+}
+
+static void measure()
+{
+    char *heapTop = sbrk(0);
+    char *stackPointer = (char *)__get_MSP();
+    size_t gap = stackPointer > heapTop ? stackPointer - heapTop : 0;
+
+    size_t freeList = 0;
+    size_t largestChunk = 0;
+    for (FreeChunk *chunk = __malloc_free_list; chunk; chunk = chunk->next)
+    {
+        freeList += chunk->size;
+        if ((size_t)chunk->size > largestChunk)
+            largestChunk = chunk->size;
+    }
+    stats.freeHeap = freeList + gap;
+    stats.largestBlock = largestChunk > gap ? largestChunk : gap;
+
+    // The deepest the stack has been is the lowest word above the heap that lost the pattern
+    uint32_t *word = alignUp(heapTop);
+    while ((char *)word < stackPointer && *word == STACK_PAINT)
+        word++;
+    stats.stackUsed = &__StackTop - (char *)word;
+    stats.stackAvailable = &__StackTop - &end;
+}
+
+#else
+
+// Host: there is no fixed RAM layout to measure, only the counters are kept
+void initMemoryMonitor()
+{
+    stats.minFreeHeap = (size_t)-1;
+    stats.minLargestBlock = (size_t)-1;
+}
+
+static void measure()
+{
+}
+
+#endif // ARDUINO_ARCH_SAMD
+
+static void takeSample()
+{
+    measure();
+    if (stats.freeHeap < stats.minFreeHeap)
+        stats.minFreeHeap = stats.freeHeap;
+    if (stats.largestBlock < stats.minLargestBlock)
+        stats.minLargestBlock = stats.largestBlock;
+    stats.allocations = allocationCount;
+    stats.steadyAllocations = allocationCount - steadyStateBaseline;
+}
+
+void markMemorySteadyState()
+{
+    steadyStateBaseline = allocationCount;
+    takeSample();
+}
+
+void updateMemoryMonitor()
+{
+    unsigned long now = millis();
+    if (now - lastSample < MEMORY_SAMPLE_INTERVAL)
+        return;
+    lastSample = now;
+    takeSample();
+
+    if (now - lastReport >= MEMORY_REPORT_INTERVAL)
+    {
+        lastReport = now;
+        printMemoryReport(Serial);
+    }
+}
+
+void getMemoryStats(MemoryStats &out)
+{
+    takeSample();
+    out = stats;
+}
+
+void printMemoryReport(Print &out)
+{
+    MemoryStats current;
+    getMemoryStats(current);
+
+    out.print("heap free ");
+    out.print((unsigned long)current.freeHeap);
+    out.print(" (min ");
+    out.print((unsigned long)current.minFreeHeap);
+    out.println(")");
+    out.print("largest block ");
+    out.print((unsigned long)current.largestBlock);
+    out.print(" (min ");
+    out.print((unsigned long)current.minLargestBlock);
+    out.println(")");
+    out.print("stack max ");
+    out.print((unsigned long)current.stackUsed);
+    out.print(" of ");
+    out.println((unsigned long)current.stackAvailable);
+#ifdef COUNT_HEAP_ALLOCATIONS
+    out.print("malloc/calloc/realloc calls ");
+    out.print(current.allocations);
+    out.print(", since setup ");
+    out.println(current.steadyAllocations);
+#else
+    out.println("allocations not counted");
+#endif
+}
@@ -0,0 +1,40 @@
+#ifndef MEMORY_MONITOR_H
+#define MEMORY_MONITOR_H
+
+#include <Arduino.h>
+
+// RAM usage of the running firmware: free heap, largest block malloc() could
+// still hand out and how deep the stack has been, sampled once per second and
+// printed to Serial once per minute and on /memory.
+//
+// Heap allocations are counted when the build wraps malloc, calloc and
+// realloc (see COUNT_HEAP_ALLOCATIONS in platformio.ini). Allocations newlib
+// makes internally through _malloc_r() are not seen. Everything allocated
+// after markMemorySteadyState() is reported separately; with -D STRING_FREE
+// it has to stay at zero.
+
+struct MemoryStats
+{
+    size_t freeHeap;        // Free list plus the gap between heap and stack
+    size_t minFreeHeap;     // Lowest freeHeap seen
+    size_t largestBlock;    // Largest single allocation that would still succeed
+    size_t minLargestBlock; // Lowest largestBlock seen
+    size_t stackUsed;       // Stack high-water mark in bytes
+    size_t stackAvailable;  // Bytes between the heap start and the stack top
+    unsigned long allocations;       // malloc/calloc/realloc calls since start-up
+    unsigned long steadyAllocations; // ... since markMemorySteadyState()
+};
+
+// Call first thing in setup(): fills the free RAM with a pattern for the stack high-water mark.
+void initMemoryMonitor();
+
+// Call at the end of setup(). Allocations after this are steady-state allocations.
+void markMemorySteadyState();
+
+// Call this function in loop().
+void updateMemoryMonitor();
+
+void getMemoryStats(MemoryStats &stats);
+void printMemoryReport(Print &out);
+
+#endif // MEMORY_MONITOR_H
@@ -0,0 +1,117 @@
+#include "PhaseGraph.h"
+#include "JunctionConfig.h"
+#include <limits.h>
+
+static bool aspectChangeAllowed(const SignalGroup &group, uint8_t from, uint8_t to)
+{
+    if (from == to)
+        return true;
+
+    switch (to)
+    {
+    case ASPECT_RED:
+        return from == ASPECT_YELLOW || from == ASPECT_YELLOW_FLASHING || from == ASPECT_DARK ||
+               (group.pedestrian && from == ASPECT_GREEN);
+    case ASPECT_RED_YELLOW:
+        return from == ASPECT_RED;
+    case ASPECT_GREEN:
+        return from == ASPECT_RED_YELLOW || (group.pedestrian && from == ASPECT_RED);
+    case ASPECT_YELLOW:
+        return from == ASPECT_GREEN;
+    default:
+        return false; // Dark and flashing are only entered by the timing plan
+    }
+}
+
+static bool allRed(const Phase &phase)
+{
+    for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
+    {
+        if (phase.aspects[i] != ASPECT_RED)
+            return false;
+    }
+    return true;
+}
+
+bool phaseChangeAllowed(uint8_t from, uint8_t to)
+{
+    const Phase &a = PHASES[from];
+    const Phase &b = PHASES[to];
+
+    bool startsTraffic = false;
+    for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
+    {
+        if (!aspectChangeAllowed(SIGNAL_GROUPS[i], a.aspects[i], b.aspects[i]))
+            return false;
+        if (a.aspects[i] == ASPECT_RED && b.aspects[i] != ASPECT_RED)
+            startsTraffic = true;
+    }
+
+    // Whoever was moving in the previous phase has to be cleared first
+    return !startsTraffic || allRed(a);
+}
+
+unsigned long minimumPhaseTime(uint8_t phase)
+{
+    const Phase &p = PHASES[phase];
+    if (allRed(p))
+        return p.duration;
+
+    bool green = false;
+    for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
+    {
+        if (p.aspects[i] == ASPECT_YELLOW || p.aspects[i] == ASPECT_RED_YELLOW)
+            return p.duration;
+        if (p.aspects[i] == ASPECT_GREEN)
+            green = true;
+    }
+    if (!green)
+        return 0;
+
+    // Pedestrians who set off in the minimum green still get the blinking tail
+    unsigned long minimum = MINIMUM_GREEN + p.blinkTail;
+    return minimum < p.duration ? minimum : p.duration;
+}
+
+uint8_t nextPhaseTowards(uint8_t from, uint8_t to, unsigned long *totalTime)
+{
+    // Dijkstra over the phases, there are at most MAX_PHASES of them
+    unsigned long distance[MAX_PHASES];
+    uint8_t firstStep[MAX_PHASES];
+    bool done[MAX_PHASES];
+    for (uint8_t i = 0; i < PHASE_COUNT; i++)
+    {
+        distance[i] = ULONG_MAX;
+        firstStep[i] = NO_PHASE;
+        done[i] = false;
+    }
+    distance[from] = 0;
+
+    for (;;)
+    {
+        uint8_t u = NO_PHASE;
+        for (uint8_t i = 0; i < PHASE_COUNT; i++)
+        {
+            if (!done[i] && distance[i] != ULONG_MAX && (u == NO_PHASE || distance[i] < distance[u]))
+                u = i;
+        }
+        if (u == NO_PHASE)
+            return NO_PHASE;
+        if (u == to && u != from)
+            break;
+        done[u] = true;
+
+        unsigned long leave = distance[u] + minimumPhaseTime(u);
+        for (uint8_t v = 0; v < PHASE_COUNT; v++)
+        {
+            if (v == u || done[v] || !phaseChangeAllowed(u, v) || leave >= distance[v])
+                continue;
+            distance[v] = leave;
+            firstStep[v] = u == from ? v : firstStep[u];
+        }
+    }
+
+    if (totalTime)
+        *totalTime = distance[to];
+    return firstStep[to];
+}
@@ -0,0 +1,28 @@
+#ifndef PHASE_GRAPH_H
+#define PHASE_GRAPH_H
+
+#include <Arduino.h>
+
+// Which phase may follow which, worked out from the aspects in PHASES[] rather
+// than from PHASE_SEQUENCE, and the shortest way to a given phase. Used by the
+// preemption to reach a green faster than the normal cycle would.
+//
+// A change is legal when every signal group makes a legal aspect change (red,
+// red-yellow, green, yellow, red; pedestrian heads switch between red and
+// green) and traffic is only started from a phase in which all groups are red.
+
+// True if the lamps may go straight from one phase to the other.
+bool phaseChangeAllowed(uint8_t from, uint8_t to);
+
+// Time a phase has to be shown before it may be left: phases with yellow or
+// red-yellow lamps and all-red clearances run for their full duration, greens
+// for MINIMUM_GREEN plus their pedestrian blinking tail (at most their
+// duration), flashing may be cut short at once.
+unsigned long minimumPhaseTime(uint8_t phase);
+
+// First phase on the shortest legal path from one phase to another, NO_PHASE
+// if there is none. The sum of minimumPhaseTime() along the path, including
+// the start phase, is stored in totalTime if it is given.
+uint8_t nextPhaseTowards(uint8_t from, uint8_t to, unsigned long *totalTime = NULL);
+
+#endif // PHASE_GRAPH_H
@@ -1,5 +1,29 @@
 #include "PinDefinitions.h"
 
+#if LAMP_DRIVER == LAMP_DRIVER_SHIFT_REGISTER
+
+// Ausgänge der Schieberegister-Kette (Q0 des ersten 74HC595 = 0)
+int LAMP1_RED = 0;
+int LAMP1_YELLOW = 1;
+int LAMP1_GREEN = 2;
+
+int LAMP2_RED = 3;
+int LAMP2_YELLOW = 4;
+int LAMP2_GREEN = 5;
+
+int LAMP3_RED = 6;
+int LAMP3_YELLOW = 7;
+int LAMP3_GREEN = 8;
+
+int LAMP1_GREEN_PED = 9;
+int LAMP1_RED_PED = 10;
+int LAMP2_GREEN_PED = 11;
+int LAMP2_RED_PED = 12;
+
+int SHIFT_REGISTER_LATCH = 10; // RCLK aller Register
+
+#else
+
 // Hauptstraße ist von links nach rechts, die Ampel 1 zeigt nach links
 int LAMP1_RED = 5;    // Rot (Auto)
 int LAMP1_YELLOW = 4; // Gelb (Auto)
@@ -21,5 +45,8 @@ int LAMP1_RED_PED = 7;    // Rot Fußgänger
 int LAMP2_GREEN_PED = 11; // Grün Fußgänger
 int LAMP2_RED_PED = 12;   // Rot Fußgänger
 
+#endif
+
 int PED_BUTTON = A1;    // Fußgänger Knopf
-int VEHICLE_BUTTON = 2; // Fahrzeugerkennung
\ No newline at end of file
+int VEHICLE_BUTTON = 2; // Fahrzeugerkennung
+int PREEMPT_INPUT = A3; // Vorrang für Einsatzfahrzeuge, aktiv solange auf LOW
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "PlanScheduler.h"
+#include "JunctionConfig.h"
+#include "TrafficLightController.h"
+
+#ifdef ARDUINO_ARCH_SAMD
+#include <RTCZero.h>
+static RTCZero rtc;
+#else
+// Host: the clock runs with the simulated millis()
+static uint32_t clockBase = 0;
+static unsigned long clockBaseMillis = 0;
+#endif
+
+static bool clockSet = false;
+static unsigned long lastCheck = 0;
+static uint8_t planOverride = FOLLOW_SCHEDULE;
+
+const uint32_t SECONDS_PER_DAY = 86400;
+const uint16_t MINUTES_PER_DAY = 1440;
+const uint16_t MINUTES_PER_WEEK = 7 * MINUTES_PER_DAY;
+
+void initPlanScheduler()
+{
+#ifdef ARDUINO_ARCH_SAMD
+    rtc.begin();
+#endif
+    clockSet = false;
+    planOverride = FOLLOW_SCHEDULE;
+    lastCheck = millis();
+}
+
+void setClock(uint32_t epoch)
+{
+#ifdef ARDUINO_ARCH_SAMD
+    rtc.setEpoch(epoch);
+#else
+    clockBase = epoch;
+    clockBaseMillis = millis();
+#endif
+    clockSet = true;
+
+    // Apply the schedule right away instead of on the next check
+    if (planOverride == FOLLOW_SCHEDULE)
+        requestTimingPlan(scheduledTimingPlan(epoch));
+}
+
+uint32_t getClock()
+{
+#ifdef ARDUINO_ARCH_SAMD
+    return rtc.getEpoch();
+#else
+    return clockBase + (millis() - clockBaseMillis) / 1000;
+#endif
+}
+
+bool clockIsSet()
+{
+    return clockSet;
+}
+
+uint8_t scheduledTimingPlan(uint32_t epoch)
+{
+    // Minutes since Sunday 00:00; 1970-01-01 was a Thursday
+    uint16_t weekday = (epoch / SECONDS_PER_DAY + 4) % 7;
+    uint16_t now = weekday * MINUTES_PER_DAY + (epoch % SECONDS_PER_DAY) / 60;
+
+    // The entry that started most recently wins
+    uint8_t plan = DEFAULT_TIMING_PLAN;
+    uint16_t bestAge = MINUTES_PER_WEEK;
+    for (uint8_t i = 0; i < WEEKLY_SCHEDULE_LENGTH; i++)
+    {
+        const ScheduleEntry &entry = WEEKLY_SCHEDULE[i];
+        for (uint8_t day = 0; day < 7; day++)
+        {
+            if (!(entry.days & (1 << day)))
+                continue;
+            uint16_t start = day * MINUTES_PER_DAY + entry.start;
+            uint16_t age = (now + MINUTES_PER_WEEK - start) % MINUTES_PER_WEEK;
+            if (age < bestAge)
+            {
+                bestAge = age;
+                plan = entry.plan;
+            }
+        }
+    }
+    return plan;
+}
+
+void overrideTimingPlan(uint8_t plan)
+{
+    if (!getTimingPlan(plan))
+        plan = FOLLOW_SCHEDULE;
+    planOverride = plan;
+
+    if (plan != FOLLOW_SCHEDULE)
+        requestTimingPlan(plan);
+    else if (clockSet)
+        requestTimingPlan(scheduledTimingPlan(getClock()));
+    else
+        requestTimingPlan(DEFAULT_TIMING_PLAN);
+}
+
+uint8_t getTimingPlanOverride()
+{
+    return planOverride;
+}
+
+void updatePlanScheduler()
+{
+    if (planOverride != FOLLOW_SCHEDULE || !clockSet || millis() - lastCheck < 1000)
+        return;
+    lastCheck = millis();
+
+    requestTimingPlan(scheduledTimingPlan(getClock()));
+}
+
+static void printTwoDigits(Print &out, unsigned int value)
+{
+    if (value < 10)
+        out.print('0');
+    out.print(value);
+}
+
+void printClock(Print &out, uint32_t epoch)
+{
+    static const char *const WEEKDAY_NAMES[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+
+    // Civil date from days since 1970 (Howard Hinnant's algorithm)
+    uint32_t days = epoch / SECONDS_PER_DAY;
+    uint32_t z = days + 719468;
+    uint32_t era = z / 146097;
+    uint32_t dayOfEra = z - era * 146097;
+    uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    uint32_t mp = (5 * dayOfYear + 2) / 153;
+    unsigned int day = dayOfYear - (153 * mp + 2) / 5 + 1;
+    unsigned int month = mp < 10 ? mp + 3 : mp - 9;
+    unsigned long year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+
+    uint32_t seconds = epoch % SECONDS_PER_DAY;
+    out.print(year);
+    out.print('-');
+    printTwoDigits(out, month);
+    out.print('-');
+    printTwoDigits(out, day);
+    out.print(' ');
+    printTwoDigits(out, seconds / 3600);
+    out.print(':');
+    printTwoDigits(out, (seconds / 60) % 60);
+    out.print(':');
+    printTwoDigits(out, seconds % 60);
+    out.print(' ');
+    out.print(WEEKDAY_NAMES[(days + 4) % 7]);
+}
@@ -0,0 +1,38 @@
+#ifndef PLAN_SCHEDULER_H
+#define PLAN_SCHEDULER_H
+
+#include <Arduino.h>
+
+// Picks the timing plan from WEEKLY_SCHEDULE (JunctionConfig.cpp) by the time
+// of day and hands it to the controller, which switches at the next cycle
+// boundary. On the board the clock is the SAMD21 RTC; on the host it is
+// derived from the simulated millis().
+
+void initPlanScheduler();
+
+// Call this function in loop(). Checks the schedule once per second.
+void updatePlanScheduler();
+
+// Local time in seconds since 1970-01-01 00:00. Until it is set the
+// controller keeps DEFAULT_TIMING_PLAN. The RTC only counts the years 2000 to
+// 2063, commandSetClock() refuses times outside of that range.
+const uint32_t CLOCK_EARLIEST = 946684800UL; // 2000-01-01 00:00
+const uint32_t CLOCK_LATEST = 2966371199UL;  // 2063-12-31 23:59:59
+void setClock(uint32_t epoch);
+uint32_t getClock();
+bool clockIsSet();
+
+// Plan the schedule asks for at the given local time.
+uint8_t scheduledTimingPlan(uint32_t epoch);
+
+// Holds a timing plan regardless of the schedule and the clock, until it is
+// called with FOLLOW_SCHEDULE. The controller still switches at the next
+// cycle boundary.
+const uint8_t FOLLOW_SCHEDULE = 0xFF;
+void overrideTimingPlan(uint8_t plan);
+uint8_t getTimingPlanOverride();
+
+// Prints the clock as "YYYY-MM-DD hh:mm:ss Www".
+void printClock(Print &out, uint32_t epoch);
+
+#endif // PLAN_SCHEDULER_H
@@ -0,0 +1,228 @@
+#include "SupervisoryLink.h"
+#include "Commands.h"
+#include "JunctionConfig.h"
+#include "TrafficLightController.h"
+#include "InputRecorder.h"
+#include "PlanScheduler.h"
+
+extern TrafficLightState currentState;
+
+const uint16_t LINK_BYTES_PER_PASS = 256; // Bounds the time spent here per loop pass
+const uint8_t EVENT_QUEUE_SIZE = 16;      // Events between two loop passes
+
+static FrameReader reader;
+static bool streaming = false;
+static uint8_t eventSequence = 0;
+
+// Events arrive from inside the controller and are sent on the next update
+static RecordedEvent eventQueue[EVENT_QUEUE_SIZE];
+static uint8_t queueHead = 0;
+static uint8_t queueLength = 0;
+
+static void queueEvent(const RecordedEvent &event)
+{
+    // When the host does not keep up, the oldest events go; the sequence gap shows it
+    if (queueLength == EVENT_QUEUE_SIZE)
+    {
+        queueHead = (queueHead + 1) % EVENT_QUEUE_SIZE;
+        queueLength--;
+        eventSequence++;
+    }
+    eventQueue[(queueHead + queueLength) % EVENT_QUEUE_SIZE] = event;
+    queueLength++;
+}
+
+static void sendFrame(const Frame &frame)
+{
+    // One write per frame, so text printed elsewhere can only fall between frames
+    uint8_t encoded[MAX_ENCODED_FRAME];
+    Serial.write(encoded, encodeFrame(frame, encoded));
+}
+
+static void sendEvents()
+{
+    Frame frame;
+    frame.type = LINK_EVENT;
+    frame.length = EVENT_LENGTH;
+    while (queueLength > 0)
+    {
+        const RecordedEvent &event = eventQueue[queueHead];
+        putUint32(frame.payload, event.time);
+        frame.payload[4] = event.type;
+        frame.payload[5] = event.arg;
+        putUint32(frame.payload + 6, event.lamps);
+        frame.sequence = eventSequence++;
+        sendFrame(frame);
+
+        queueHead = (queueHead + 1) % EVENT_QUEUE_SIZE;
+        queueLength--;
+    }
+}
+
+static uint8_t linkResult(CommandResult result)
+{
+    if (result == COMMAND_OK)
+        return LINK_OK;
+    return result == COMMAND_REFUSED ? LINK_REFUSED : LINK_BAD_ARGUMENT;
+}
+
+static void writeStatus(Frame &answer)
+{
+    PreemptionStatus preemption;
+    getPreemptionStatus(preemption);
+
+    uint8_t *out = answer.payload;
+    out[STATUS_STATE] = currentState;
+    out[STATUS_ACTIVE_PLAN] = getActiveTimingPlan();
+    out[STATUS_PLAN_OVERRIDE] = getTimingPlanOverride();
+    out[STATUS_CLOCK_SET] = clockIsSet();
+    putUint32(out + STATUS_CLOCK, getClock());
+    putUint32(out + STATUS_MILLIS, millis());
+    putUint32(out + STATUS_LAMPS, sampleLampOutputs());
+    out[STATUS_PREEMPT_TARGET] = preemption.target;
+    out[STATUS_PREEMPT_REACHED] = preemption.reached;
+    putUint32(out + STATUS_PREEMPT_LATENCY, preemption.latency);
+    out[STATUS_RECORDING] = isRecording();
+    putUint16(out + STATUS_EVENT_COUNT, recordedEventCount());
+    answer.length = STATUS_LENGTH;
+}
+
+// Timing plan with the effective duration of every phase
+static_assert(4 + 4 * MAX_PHASES <= MAX_FRAME_PAYLOAD, "Plan durations do not fit into a frame");
+static void writePlan(Frame &answer, uint8_t index)
+{
+    const TimingPlan &plan = *getTimingPlan(index);
+    uint8_t *out = answer.payload;
+    out[1] = index;
+    out[2] = plan.mode;
+    out[3] = PHASE_COUNT;
+    uint8_t length = 4;
+    for (uint8_t i = 0; i < PHASE_COUNT; i++, length += 4)
+        putUint32(out + length, plan.durations[i] ? plan.durations[i] : PHASES[i].duration);
+
+    for (const char *c = plan.name; *c && length < MAX_FRAME_PAYLOAD; c++)
+        out[length++] = *c;
+    answer.length = length;
+}
+
+// Required payload length of each request type, -1 for any or unknown types
+static int requestLength(uint8_t type)
+{
+    switch (type)
+    {
+    case LINK_GET_STATUS:
+    case LINK_RELEASE:
+    case LINK_START_CAPTURE:
+    case LINK_STOP_CAPTURE:
+        return 0;
+    case LINK_SET_CLOCK:
+        return 4;
+    case LINK_SET_STATE:
+    case LINK_GET_PLAN:
+    case LINK_SELECT_PLAN:
+    case LINK_PREEMPT:
+    case LINK_STREAM_EVENTS:
+        return 1;
+    default:
+        return -1;
+    }
+}
+
+static void handleRequest(const Frame &request)
+{
+    Frame answer;
+    answer.type = request.type | LINK_RESPONSE;
+    answer.sequence = request.sequence;
+    answer.length = 1;
+    uint8_t &result = answer.payload[0];
+    result = LINK_OK;
+
+    int expected = requestLength(request.type);
+    const uint8_t *in = request.payload;
+    if (expected >= 0 && request.length != expected)
+        result = LINK_BAD_LENGTH;
+    else
+    {
+        switch (request.type)
+        {
+        case LINK_PING:
+            answer.length = request.length < MAX_FRAME_PAYLOAD ? 1 + request.length : MAX_FRAME_PAYLOAD;
+            memcpy(answer.payload + 1, in, answer.length - 1);
+            break;
+        case LINK_GET_STATUS:
+            writeStatus(answer);
+            break;
+        case LINK_SET_STATE:
+            result = linkResult(commandSetState(in[0]));
+            break;
+        case LINK_SET_CLOCK:
+            result = linkResult(commandSetClock(getUint32(in)));
+            break;
+        case LINK_GET_PLAN:
+            if (getTimingPlan(in[0]))
+                writePlan(answer, in[0]);
+            else
+                result = LINK_BAD_ARGUMENT;
+            break;
+        case LINK_SELECT_PLAN:
+            result = linkResult(commandSelectTimingPlan(in[0]));
+            break;
+        case LINK_SET_PLAN:
+            if (request.length < 2 || in[1] != PHASE_COUNT || request.length != 2 + 4 * PHASE_COUNT)
+                result = LINK_BAD_LENGTH;
+            else
+            {
+                unsigned long durations[MAX_PHASES];
+                for (uint8_t i = 0; i < PHASE_COUNT; i++)
+                    durations[i] = getUint32(in + 2 + 4 * i);
+                result = linkResult(commandWriteCustomPlan(in[0], durations));
+            }
+            break;
+        case LINK_PREEMPT:
+            result = linkResult(commandPreempt(in[0]));
+            break;
+        case LINK_RELEASE:
+            result = linkResult(commandReleasePreemption());
+            break;
+        case LINK_START_CAPTURE:
+            result = linkResult(commandStartCapture());
+            break;
+        case LINK_STOP_CAPTURE:
+            result = linkResult(commandStopCapture());
+            break;
+        case LINK_STREAM_EVENTS:
+            streaming = in[0] != 0;
+            queueLength = 0;
+            setEventListener(streaming ? queueEvent : NULL);
+            break;
+        default:
+            result = LINK_UNKNOWN_TYPE;
+            break;
+        }
+    }
+
+    // Events caused by the command go out after its answer
+    sendFrame(answer);
+}
+
+void initSupervisoryLink()
+{
+    reader = FrameReader();
+    streaming = false;
+    queueLength = 0;
+    setEventListener(NULL);
+}
+
+void updateSupervisoryLink()
+{
+    Frame request;
+    for (uint16_t i = 0; i < LINK_BYTES_PER_PASS && Serial.available() > 0; i++)
+    {
+        int c = Serial.read();
+        if (c >= 0 && reader.feed(c, request))
+            handleRequest(request);
+    }
+
+    if (streaming)
+        sendEvents();
+}
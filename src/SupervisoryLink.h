@@ -0,0 +1,72 @@
+#ifndef SUPERVISORY_LINK_H
+#define SUPERVISORY_LINK_H
+
+#include <Arduino.h>
+#include "FrameCodec.h"
+
+// Binary supervisory protocol on the USB serial port, for a cabinet PC that
+// watches and commands the controller (src/host/supervisor_main.cpp). Frames
+// as described in FrameCodec.h; they share the port with the text printed to
+// Serial, which the host skips.
+//
+// The host sends requests with a sequence number of its choice; the answer
+// has the request type | LINK_RESPONSE, the same sequence number and the
+// LinkResult as the first payload byte. Commands go through the same
+// handlers as the web interface (Commands.h). While events are streamed, every
+// controller input arrives as an unsolicited LINK_EVENT frame whose sequence
+// number counts up, so the host sees gaps.
+//
+// Multi-byte fields are little-endian.
+
+enum LinkMessage : uint8_t
+{
+    LINK_PING = 0x01,          // Any payload, echoed back
+    LINK_GET_STATUS = 0x02,    // Answer: LinkStatus layout below
+    LINK_SET_STATE = 0x03,     // phase
+    LINK_SET_CLOCK = 0x04,     // uint32 local seconds since 1970
+    LINK_GET_PLAN = 0x05,      // plan; answer: plan, mode, phase count, durations (uint32 ms each), name
+    LINK_SELECT_PLAN = 0x06,   // plan, CUSTOM_TIMING_PLAN or FOLLOW_SCHEDULE
+    LINK_PREEMPT = 0x07,       // phase
+    LINK_RELEASE = 0x08,       // -
+    LINK_START_CAPTURE = 0x09, // -
+    LINK_STOP_CAPTURE = 0x0A,  // -
+    LINK_STREAM_EVENTS = 0x0B, // 1 = on, 0 = off
+    LINK_SET_PLAN = 0x0C,      // mode, phase count, durations (uint32 ms each, 0 = default); writes CUSTOM_TIMING_PLAN
+
+    LINK_EVENT = 0x40,   // Unsolicited: uint32 time, type, arg, uint32 lamps (see RecordedEvent)
+    LINK_RESPONSE = 0x80 // Set in the type of every answer
+};
+
+enum LinkResult : uint8_t
+{
+    LINK_OK,
+    LINK_BAD_ARGUMENT, // COMMAND_BAD_ARGUMENT
+    LINK_REFUSED,      // COMMAND_REFUSED
+    LINK_UNKNOWN_TYPE,
+    LINK_BAD_LENGTH
+};
+
+// Answer to LINK_GET_STATUS, offsets into the payload after the result byte
+const uint8_t STATUS_STATE = 1;           // Current phase
+const uint8_t STATUS_ACTIVE_PLAN = 2;
+const uint8_t STATUS_PLAN_OVERRIDE = 3;   // FOLLOW_SCHEDULE if the schedule decides
+const uint8_t STATUS_CLOCK_SET = 4;
+const uint8_t STATUS_CLOCK = 5;           // uint32
+const uint8_t STATUS_MILLIS = 9;          // uint32
+const uint8_t STATUS_LAMPS = 13;          // uint32, see sampleLampOutputs()
+const uint8_t STATUS_PREEMPT_TARGET = 17; // NO_PHASE if not preempted
+const uint8_t STATUS_PREEMPT_REACHED = 18;
+const uint8_t STATUS_PREEMPT_LATENCY = 19; // uint32 ms
+const uint8_t STATUS_RECORDING = 23;
+const uint8_t STATUS_EVENT_COUNT = 24;     // uint16, events in the capture
+const uint8_t STATUS_LENGTH = 26;
+
+const uint8_t EVENT_LENGTH = 10;
+
+void initSupervisoryLink();
+
+// Call this function in loop(). Handles the requests that have arrived and
+// sends the queued events.
+void updateSupervisoryLink();
+
+#endif // SUPERVISORY_LINK_H
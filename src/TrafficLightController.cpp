@@ -1,168 +1,80 @@
 #include "TrafficLightController.h"
-#include "PinDefinitions.h"
-#include "TestLamps.h"
+#include "JunctionConfig.h"
+#include "InputRecorder.h"
+#include "LampDriver.h"
+#include "BlinkTimer.h"
+#include "PhaseGraph.h"
 
-// --- State Variables and Timing Constants ---
+#ifdef STRING_FREE
+// Nothing in the controller may allocate, any use of String is a compile error
+#pragma GCC poison String
+#endif
+
+// --- State Variables ---
 TrafficLightState currentState = MAIN_GREEN; // Make currentState accessible globally
 static unsigned long stateStartTime = 0;
 
-const unsigned long MAIN_GREEN_DURATION_DEFAULT = 10000; // 10 sec.
-static unsigned long mainGreenDuration = MAIN_GREEN_DURATION_DEFAULT;
-const unsigned long MAIN_YELLOW_DURATION = 3000;       // 3 sec.
-const unsigned long ALL_RED_DURATION = 2000;           // 2 sec.
-const unsigned long SIDE_GREEN_DURATION = 5000;        // 5 sec.
-const unsigned long SIDE_YELLOW_DURATION = 3000;       // 3 sec.
-const unsigned long PEDESTRIAN_GREEN_DURATION = 10000; // 10 sec
+// Position in PHASE_SEQUENCE, the cycle continues from here
+static uint8_t sequenceStep = 0;
 
 // Flags to debounce button presses
 static bool pedestrianFlag = false;
 static bool vehicleFlag = false;
 
-// Variable to direct the traffic flow
-// true = main road, false = side road
-static bool directionIsMain = true;
+// Aspect each signal group currently shows, so a phase change only writes the groups that change
+static uint8_t shownAspects[MAX_SIGNAL_GROUPS];
+
+// True while the pedestrian greens blink at the end of their phase
+static bool pedestrianBlinking = false;
+
+// Timing plan in use and the one to switch to at the next cycle boundary
+static uint8_t activePlan = DEFAULT_TIMING_PLAN;
+static uint8_t pendingPlan = DEFAULT_TIMING_PLAN;
+
+// Timing plan written over the supervisory link, CUSTOM_TIMING_PLAN
+static TimingPlan customPlan = {"CUSTOM", PLAN_CYCLE, {0}};
+
+// Preemption: requested green (NO_PHASE if none), when it was requested and how long the last one took
+static uint8_t preemptTarget = NO_PHASE;
+static unsigned long preemptTime = 0;
+static unsigned long preemptLatency = 0;
 
 // --- Internal Functions ---
 
-// Update the lamps based on the current state.
-// Uses a static variable to track the previous state and only update necessary pins.
-static void setLights(TrafficLightState state)
+// Start or stop blinking the pedestrian greens that are lit. The blink timer does the blinking.
+static void blinkPedestrianGreens(bool blink)
 {
-    static TrafficLightState previousState = MAIN_GREEN;
-
-    // Reset lights that were set in the previous state
-    switch (previousState)
+    for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
     {
-    case MAIN_GREEN:
-        digitalWrite(LAMP1_GREEN, LOW);
-        digitalWrite(LAMP3_GREEN, LOW);
-        digitalWrite(LAMP2_RED, LOW);
-        break;
-    case MAIN_YELLOW:
-        digitalWrite(LAMP1_YELLOW, LOW);
-        digitalWrite(LAMP3_YELLOW, LOW);
-        digitalWrite(LAMP2_RED, LOW);
-        break;
-    case ALL_RED:
-        digitalWrite(LAMP1_RED, LOW);
-        digitalWrite(LAMP2_RED, LOW);
-        digitalWrite(LAMP3_RED, LOW);
-        break;
-    case SIDE_RED_YELLOW:
-        digitalWrite(LAMP2_RED, LOW);
-        digitalWrite(LAMP2_YELLOW, LOW);
-        digitalWrite(LAMP1_RED, LOW);
-        digitalWrite(LAMP3_RED, LOW);
-        break;
-    case SIDE_GREEN:
-        digitalWrite(LAMP2_GREEN, LOW);
-        digitalWrite(LAMP1_RED, LOW);
-        digitalWrite(LAMP3_RED, LOW);
-        break;
-    case SIDE_YELLOW:
-        digitalWrite(LAMP2_YELLOW, LOW);
-        digitalWrite(LAMP1_RED, LOW);
-        digitalWrite(LAMP3_RED, LOW);
-        break;
-    case MAIN_RED_YELLOW:
-        digitalWrite(LAMP1_RED, LOW);
-        digitalWrite(LAMP1_YELLOW, LOW);
-        digitalWrite(LAMP3_RED, LOW);
-        digitalWrite(LAMP3_YELLOW, LOW);
-        digitalWrite(LAMP2_RED, LOW);
-        break;
-    case PEDESTRIAN_GREEN:
-        digitalWrite(LAMP1_GREEN_PED, LOW);
-        digitalWrite(LAMP1_RED_PED, HIGH);
-        digitalWrite(LAMP2_GREEN_PED, LOW);
-        digitalWrite(LAMP2_RED_PED, HIGH);
-        break;
+        if (SIGNAL_GROUPS[i].pedestrian && shownAspects[i] == ASPECT_GREEN)
+            setLampBlink(SIGNAL_GROUPS[i].green, blink ? BLINK_FAST : BLINK_NONE);
     }
+    pedestrianBlinking = blink;
+}
+
+// Update the lamps based on the current state.
+// Only signal groups whose aspect differs from the previous phase are written,
+// unless force is set (at start-up, when the pins are in an unknown state).
+static void setLights(TrafficLightState state, bool force = false)
+{
+    const Phase &phase = PHASES[state];
 
-    // Set lights for the new state
-    switch (state)
+    if (pedestrianBlinking)
+        blinkPedestrianGreens(false);
+
+    for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
     {
-    case MAIN_GREEN:
-        digitalWrite(LAMP1_GREEN, HIGH);
-        digitalWrite(LAMP3_GREEN, HIGH);
-        digitalWrite(LAMP2_RED, HIGH);
-        break;
-    case MAIN_YELLOW:
-        digitalWrite(LAMP1_YELLOW, HIGH);
-        digitalWrite(LAMP3_YELLOW, HIGH);
-        digitalWrite(LAMP2_RED, HIGH);
-        break;
-    case ALL_RED:
-        digitalWrite(LAMP1_RED, HIGH);
-        digitalWrite(LAMP2_RED, HIGH);
-        digitalWrite(LAMP3_RED, HIGH);
-        break;
-    case SIDE_RED_YELLOW:
-        digitalWrite(LAMP2_RED, HIGH);
-        digitalWrite(LAMP2_YELLOW, HIGH);
-        digitalWrite(LAMP1_RED, HIGH);
-        digitalWrite(LAMP3_RED, HIGH);
-        break;
-    case SIDE_GREEN:
-        digitalWrite(LAMP2_GREEN, HIGH);
-        digitalWrite(LAMP1_RED, HIGH);
-        digitalWrite(LAMP3_RED, HIGH);
-        break;
-    case SIDE_YELLOW:
-        digitalWrite(LAMP2_YELLOW, HIGH);
-        digitalWrite(LAMP1_RED, HIGH);
-        digitalWrite(LAMP3_RED, HIGH);
-        break;
-    case MAIN_RED_YELLOW:
-        digitalWrite(LAMP1_RED, HIGH);
-        digitalWrite(LAMP1_YELLOW, HIGH);
-        digitalWrite(LAMP3_RED, HIGH);
-        digitalWrite(LAMP3_YELLOW, HIGH);
-        digitalWrite(LAMP2_RED, HIGH);
-        break;
-    case PEDESTRIAN_GREEN:
-        digitalWrite(LAMP1_GREEN_PED, HIGH);
-        digitalWrite(LAMP1_RED_PED, LOW);
-        digitalWrite(LAMP2_GREEN_PED, HIGH);
-        digitalWrite(LAMP2_RED_PED, LOW);
-
-        digitalWrite(LAMP1_RED, HIGH);
-        digitalWrite(LAMP2_RED, HIGH);
-        digitalWrite(LAMP3_RED, HIGH);
-        break;
+        if (force || phase.aspects[i] != shownAspects[i])
+        {
+            showAspect(SIGNAL_GROUPS[i], phase.aspects[i]);
+            shownAspects[i] = phase.aspects[i];
+        }
     }
-
-    previousState = state;
+    latchLamps();
 
     // Print the current state for debugging
     Serial.print("Current state: ");
-    switch (state)
-    {
-    case MAIN_GREEN:
-        Serial.println("MAIN_GREEN");
-        break;
-    case MAIN_YELLOW:
-        Serial.println("MAIN_YELLOW");
-        break;
-    case ALL_RED:
-        Serial.println("ALL_RED");
-        break;
-    case SIDE_RED_YELLOW:
-        Serial.println("SIDE_RED_YELLOW");
-        break;
-    case SIDE_GREEN:
-        Serial.println("SIDE_GREEN");
-        break;
-    case SIDE_YELLOW:
-        Serial.println("SIDE_YELLOW");
-        break;
-    case MAIN_RED_YELLOW:
-        Serial.println("MAIN_RED_YELLOW");
-        break;
-    case PEDESTRIAN_GREEN:
-        Serial.println("PEDESTRIAN_GREEN");
-        break;
-    }
+    Serial.println(getStateName(state));
 }
 
 // Change the current state, update the timer, and set the lights.
@@ -173,90 +85,235 @@ static void changeState(TrafficLightState newState)
     setLights(newState);
 }
 
+static void changeState(uint8_t newPhase)
+{
+    changeState((TrafficLightState)newPhase);
+}
+
+// Duration of the phase from the active timing plan, shortened while a vehicle demand is pending.
+static unsigned long phaseDuration(uint8_t phaseIndex)
+{
+    const Phase &phase = PHASES[phaseIndex];
+    if (vehicleFlag && phase.demandDuration)
+        return phase.demandDuration;
+    unsigned long planned = getTimingPlan(activePlan)->durations[phaseIndex];
+    return planned ? planned : phase.duration;
+}
+
+// True while the timing plan rests in the first phase of the cycle and nobody is waiting
+static bool restingInGreen()
+{
+    return getTimingPlan(activePlan)->mode == PLAN_REST_IN_GREEN && sequenceStep == 0 &&
+           currentState == PHASE_SEQUENCE[0] && !pedestrianFlag && !vehicleFlag;
+}
+
+// True while the current phase is held past its duration
+static bool phaseHeld()
+{
+    if (PHASES[currentState].flags & PHASE_FLASHING)
+        return getTimingPlan(activePlan)->mode == PLAN_FLASHING;
+    return restingInGreen();
+}
+
+// Last position of the phase in the sequence
+static uint8_t lastSequenceStep(uint8_t phase)
+{
+    for (uint8_t step = PHASE_SEQUENCE_LENGTH; step > 0; step--)
+    {
+        if (PHASE_SEQUENCE[step - 1] == phase)
+            return step - 1;
+    }
+    return 0;
+}
+
+// Position of the phase in the sequence, preferring the one that is followed by next
+static uint8_t sequenceStepOf(uint8_t phase, uint8_t next)
+{
+    uint8_t found = sequenceStep;
+    bool any = false;
+    for (uint8_t step = 0; step < PHASE_SEQUENCE_LENGTH; step++)
+    {
+        if (PHASE_SEQUENCE[step] != phase)
+            continue;
+        if (PHASE_SEQUENCE[(step + 1) % PHASE_SEQUENCE_LENGTH] == next)
+            return step;
+        if (!any)
+            found = step;
+        any = true;
+    }
+    return found;
+}
+
+static void clearServedDemands(const Phase &phase)
+{
+    if (phase.flags & PHASE_SERVES_PEDESTRIAN)
+        pedestrianFlag = false; // Reset pedestrian flag
+    if (phase.flags & PHASE_SERVES_VEHICLE)
+        vehicleFlag = false; // Reset vehicle detection
+}
+
+// Leave the current phase once its time is up.
+static void advancePhase()
+{
+    const Phase &phase = PHASES[currentState];
+
+    clearServedDemands(phase);
+
+    if (phase.after != NO_PHASE)
+    {
+        // Back from flashing, the cycle starts over through its last clearance
+        if (phase.flags & PHASE_FLASHING)
+            sequenceStep = lastSequenceStep(phase.after);
+        changeState(phase.after);
+    }
+    else if ((phase.flags & PHASE_CLEARANCE) && pedestrianFlag)
+        changeState(PEDESTRIAN_PHASE);
+    else
+    {
+        uint8_t nextStep = (sequenceStep + 1) % PHASE_SEQUENCE_LENGTH;
+
+        // Timing plans only change at the cycle boundary
+        if (nextStep == 0)
+        {
+            activePlan = pendingPlan;
+            if (getTimingPlan(activePlan)->mode == PLAN_FLASHING)
+            {
+                changeState(FLASHING_PHASE);
+                return;
+            }
+        }
+        sequenceStep = nextStep;
+        changeState(PHASE_SEQUENCE[sequenceStep]);
+    }
+}
+
+// Elapsed time after which the current phase may be left for the preemption.
+// A phase with blinking pedestrian greens shows its whole blinking tail first,
+// starting no earlier than the request and no later than it would anyway.
+static unsigned long preemptedPhaseEnd()
+{
+    const Phase &phase = PHASES[currentState];
+    unsigned long minimum = minimumPhaseTime(currentState);
+    if (!phase.blinkTail)
+        return minimum;
+
+    unsigned long duration = phaseDuration(currentState);
+    unsigned long requested = (long)(preemptTime - stateStartTime) > 0 ? preemptTime - stateStartTime : 0;
+    unsigned long blinkStart = minimum > phase.blinkTail ? minimum - phase.blinkTail : 0;
+    if (requested > blinkStart)
+        blinkStart = requested;
+    if (duration > phase.blinkTail && blinkStart > duration - phase.blinkTail)
+        blinkStart = duration - phase.blinkTail;
+    return blinkStart + phase.blinkTail;
+}
+
+// Take the next phase on the shortest legal path to the preemption target once
+// the current one may be left, then hold the target. Returns true on a transition.
+static bool updatePreemption(unsigned long currentTime, unsigned long elapsedTime)
+{
+    if (currentTime - preemptTime >= PREEMPTION_TIMEOUT)
+    {
+        Serial.println("Preemption timed out");
+        preemptTarget = NO_PHASE;
+        return false;
+    }
+
+    if (currentState == preemptTarget)
+        return false;
+
+    unsigned long phaseEnd = preemptedPhaseEnd();
+    const Phase &phase = PHASES[currentState];
+    if (phase.blinkTail && !pedestrianBlinking && elapsedTime + phase.blinkTail >= phaseEnd)
+    {
+        blinkPedestrianGreens(true);
+        latchLamps();
+    }
+    if (elapsedTime < phaseEnd)
+        return false;
+
+    uint8_t next = nextPhaseTowards(currentState, preemptTarget);
+    if (next == NO_PHASE)
+        return false;
+
+    clearServedDemands(PHASES[currentState]);
+    sequenceStep = sequenceStepOf(next, next == preemptTarget ? NO_PHASE : nextPhaseTowards(next, preemptTarget));
+    changeState(next);
+
+    if (next == preemptTarget)
+    {
+        preemptLatency = currentTime - preemptTime;
+        Serial.print("Preemption latency: ");
+        Serial.print(preemptLatency);
+        Serial.println(" ms");
+    }
+    return true;
+}
+
 // --- Public Functions ---
 
 void initTrafficController()
 {
-    currentState = MAIN_GREEN;
+    initLampDriver();
+    initBlinkTimer();
+
+    sequenceStep = 0;
+    activePlan = pendingPlan;
+    currentState = (TrafficLightState)PHASE_SEQUENCE[0];
     stateStartTime = millis();
-    setLights(currentState);
+    setLights(currentState, true);
 }
 
 void updateTrafficController()
 {
     unsigned long currentTime = millis();
     unsigned long elapsedTime = currentTime - stateStartTime;
+    const Phase &phase = PHASES[currentState];
+    unsigned long duration = phaseDuration(currentState);
+
+    feedBlinkTimer();
 
-    switch (currentState)
+    // The blink timer switched to flashing while the loop was stuck, carry on from there
+    if (blinkTimerFellBack())
     {
-    case MAIN_GREEN:
-        if (elapsedTime >= mainGreenDuration)
-            changeState(MAIN_YELLOW);
-        break;
-
-    case MAIN_YELLOW:
-        if (elapsedTime >= MAIN_YELLOW_DURATION)
-            changeState(ALL_RED);
-        break;
-
-    case ALL_RED:
-        directionIsMain = !directionIsMain; // Toggle direction
-        if (elapsedTime >= ALL_RED_DURATION)
-        {
-            if (pedestrianFlag)
-                changeState(PEDESTRIAN_GREEN);
-            else if (directionIsMain)
-                changeState(MAIN_RED_YELLOW);
-            else
-                changeState(SIDE_RED_YELLOW);
-        }
-        break;
+        currentState = (TrafficLightState)FLASHING_PHASE;
+        stateStartTime = currentTime;
+        setLights(currentState, true);
+        recordEvent(EVENT_LAMP_FALLBACK, currentState, currentTime);
+        return;
+    }
 
-    case SIDE_RED_YELLOW:
-        if (elapsedTime >= ALL_RED_DURATION)
-            changeState(SIDE_GREEN);
-        break;
+    // A preemption overrides the cycle and the timing plans until it is released
+    if (preemptTarget != NO_PHASE)
+    {
+        if (updatePreemption(currentTime, elapsedTime))
+            recordEvent(EVENT_TICK, currentState, currentTime);
+        if (preemptTarget != NO_PHASE)
+            return;
+    }
 
-    case SIDE_GREEN:
-        if (elapsedTime >= SIDE_GREEN_DURATION)
+    // Flashing and resting in green are outside the cycle, so a new plan takes over at once
+    if (pendingPlan != activePlan && ((phase.flags & PHASE_FLASHING) || (elapsedTime >= duration && restingInGreen())))
+    {
+        activePlan = pendingPlan;
+        if (getTimingPlan(activePlan)->mode == PLAN_FLASHING && !(phase.flags & PHASE_FLASHING))
         {
-            changeState(SIDE_YELLOW);
-            vehicleFlag = false;                             // Reset vehicle detection
-            mainGreenDuration = MAIN_GREEN_DURATION_DEFAULT; // Reset green time
+            changeState(FLASHING_PHASE);
+            recordEvent(EVENT_TICK, currentState, currentTime);
+            return;
         }
-        break;
-
-    case SIDE_YELLOW:
-        if (elapsedTime >= SIDE_YELLOW_DURATION)
-            changeState(ALL_RED);
-        break;
+    }
 
-    case MAIN_RED_YELLOW:
-        if (elapsedTime >= ALL_RED_DURATION)
-            changeState(MAIN_GREEN);
-        break;
+    if (elapsedTime >= duration && !phaseHeld())
+    {
+        advancePhase();
 
-    case PEDESTRIAN_GREEN:
-        if (elapsedTime >= PEDESTRIAN_GREEN_DURATION)
-        {
-            pedestrianFlag = false; // Reset pedestrian flag
-            changeState(ALL_RED);
-        }
-        else if (PEDESTRIAN_GREEN_DURATION - elapsedTime <= 3000)
-        {
-            // Blink pedestrian green light
-            if ((elapsedTime / 250) % 2 == 0) // Toggle every 250ms
-            {
-                digitalWrite(LAMP1_GREEN_PED, HIGH);
-                digitalWrite(LAMP2_GREEN_PED, HIGH);
-            }
-            else
-            {
-                digitalWrite(LAMP1_GREEN_PED, LOW);
-                digitalWrite(LAMP2_GREEN_PED, LOW);
-            }
-        }
-        break;
+        // Record the pass that caused a transition, so a replay ticks at the same time
+        recordEvent(EVENT_TICK, currentState, currentTime);
+    }
+    else if (phase.blinkTail && !pedestrianBlinking && elapsedTime < duration && duration - elapsedTime <= phase.blinkTail)
+    {
+        blinkPedestrianGreens(true);
+        latchLamps();
     }
 }
 
@@ -264,16 +321,29 @@ void handlePedestrianButton()
 {
     if (!pedestrianFlag)
     {
+        unsigned long pressTime = millis();
         Serial.println("Pedestrian button pressed");
         pedestrianFlag = true;
 
-        // blink pedestrian green light
-        bool currentGreen = digitalRead(LAMP1_GREEN_PED);
-        digitalWrite(LAMP1_GREEN_PED, !currentGreen);
-        digitalWrite(LAMP2_GREEN_PED, !currentGreen);
+        // blink pedestrian green lights
+        bool levels[MAX_SIGNAL_GROUPS];
+        for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
+        {
+            if (!SIGNAL_GROUPS[i].pedestrian)
+                continue;
+            levels[i] = readLamp(SIGNAL_GROUPS[i].green);
+            writeLamp(SIGNAL_GROUPS[i].green, !levels[i]);
+        }
+        latchLamps();
         delay(100);
-        digitalWrite(LAMP1_GREEN_PED, currentGreen);
-        digitalWrite(LAMP2_GREEN_PED, currentGreen);
+        for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
+        {
+            if (SIGNAL_GROUPS[i].pedestrian)
+                writeLamp(SIGNAL_GROUPS[i].green, levels[i]);
+        }
+        latchLamps();
+
+        recordEvent(EVENT_PEDESTRIAN_BUTTON, 0, pressTime);
     }
 }
 
@@ -281,34 +351,230 @@ void handleVehicleButton()
 {
     if (!vehicleFlag)
     {
+        unsigned long detectTime = millis();
         Serial.println("Vehicle detection button pressed");
-        vehicleFlag = true;
-        mainGreenDuration = MAIN_GREEN_DURATION_DEFAULT / 2; // Reduce main green duration
+        vehicleFlag = true; // Shortens the main green, see Phase::demandDuration
 
         // blink the yellow light of the side road
-        bool currentYellow = digitalRead(LAMP1_YELLOW);
-        digitalWrite(LAMP2_YELLOW, !currentYellow);
+        int yellow = SIGNAL_GROUPS[VEHICLE_FEEDBACK_GROUP].yellow;
+        bool currentYellow = readLamp(yellow);
+        writeLamp(yellow, !currentYellow);
+        latchLamps();
         delay(100);
-        digitalWrite(LAMP2_YELLOW, currentYellow);
+        writeLamp(yellow, currentYellow);
+        latchLamps();
+
+        recordEvent(EVENT_VEHICLE_SENSOR, 0, detectTime);
     }
 }
 
+bool setTrafficLightPhase(uint8_t phase)
+{
+    if (phase >= PHASE_COUNT)
+        return false;
+    if (preemptTarget != NO_PHASE)
+    {
+        Serial.println("Preempted, state not changed");
+        return false;
+    }
+    TrafficLightState newState = (TrafficLightState)phase;
+
+    // Continue the cycle from the next occurrence of the new phase
+    for (uint8_t i = 0; i < PHASE_SEQUENCE_LENGTH; i++)
+    {
+        uint8_t step = (sequenceStep + i) % PHASE_SEQUENCE_LENGTH;
+        if (PHASE_SEQUENCE[step] == newState)
+        {
+            sequenceStep = step;
+            break;
+        }
+    }
+
+    unsigned long commandTime = millis();
+    changeState(newState);
+    recordEvent(EVENT_WEB_SET, newState, commandTime);
+    return true;
+}
+
+void setTrafficLightState(const char *state)
+{
+    TrafficLightState newState;
+    if (parseStateName(state, newState))
+        setTrafficLightPhase(newState);
+}
+
+#ifndef STRING_FREE
 void setTrafficLightState(const String &state)
 {
-    if (state == "MAIN_GREEN")
-        changeState(MAIN_GREEN);
-    else if (state == "MAIN_YELLOW")
-        changeState(MAIN_YELLOW);
-    else if (state == "ALL_RED")
-        changeState(ALL_RED);
-    else if (state == "SIDE_RED_YELLOW")
-        changeState(SIDE_RED_YELLOW);
-    else if (state == "SIDE_GREEN")
-        changeState(SIDE_GREEN);
-    else if (state == "SIDE_YELLOW")
-        changeState(SIDE_YELLOW);
-    else if (state == "MAIN_RED_YELLOW")
-        changeState(MAIN_RED_YELLOW);
-    else if (state == "PEDESTRIAN_GREEN")
-        changeState(PEDESTRIAN_GREEN);
+    setTrafficLightState(state.c_str());
+}
+#endif
+
+bool requestPreemption(uint8_t phase)
+{
+    if (phase >= PHASE_COUNT)
+        return false;
+
+    bool vehicleGreen = false;
+    for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
+    {
+        if (!SIGNAL_GROUPS[i].pedestrian && PHASES[phase].aspects[i] == ASPECT_GREEN)
+            vehicleGreen = true;
+    }
+    if (!vehicleGreen)
+        return false;
+    if (phase == preemptTarget)
+        return true;
+
+    unsigned long requestTime = millis();
+    preemptTarget = phase;
+    preemptTime = requestTime;
+
+    Serial.print("Preemption to ");
+    Serial.print(PHASES[phase].name);
+    if (currentState == phase)
+    {
+        preemptLatency = 0;
+        Serial.println(", already shown");
+    }
+    else
+    {
+        // Expected time, the current phase may already have run for a while
+        unsigned long pathTime = 0;
+        nextPhaseTowards(currentState, phase, &pathTime);
+        unsigned long elapsedTime = requestTime - stateStartTime;
+        unsigned long phaseEnd = preemptedPhaseEnd();
+        pathTime = pathTime - minimumPhaseTime(currentState) + (elapsedTime < phaseEnd ? phaseEnd - elapsedTime : 0);
+        Serial.print(", expected after ");
+        Serial.print(pathTime);
+        Serial.println(" ms");
+    }
+
+    recordEvent(EVENT_PREEMPT, phase, requestTime);
+    return true;
+}
+
+void releasePreemption()
+{
+    if (preemptTarget == NO_PHASE)
+        return;
+
+    Serial.println("Preemption released");
+    preemptTarget = NO_PHASE;
+    recordEvent(EVENT_PREEMPT_RELEASE, 0, millis());
+}
+
+void getPreemptionStatus(PreemptionStatus &status)
+{
+    status.target = preemptTarget;
+    status.reached = preemptTarget != NO_PHASE && currentState == preemptTarget;
+    status.latency = preemptLatency;
+}
+
+void requestTimingPlan(uint8_t plan)
+{
+    if (!getTimingPlan(plan) || plan == pendingPlan)
+        return;
+
+    Serial.print("Timing plan: ");
+    Serial.println(getTimingPlan(plan)->name);
+    pendingPlan = plan;
+    recordEvent(EVENT_PLAN, plan, millis());
+}
+
+uint8_t getActiveTimingPlan()
+{
+    return activePlan;
+}
+
+const TimingPlan *getTimingPlan(uint8_t plan)
+{
+    if (plan < TIMING_PLAN_COUNT)
+        return &TIMING_PLANS[plan];
+    return plan == CUSTOM_TIMING_PLAN ? &customPlan : NULL;
+}
+
+// Yellow and red-yellow times are fixed by the junction, not by the timing plan
+static bool showsYellow(const Phase &phase)
+{
+    for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
+    {
+        if (phase.aspects[i] == ASPECT_YELLOW || phase.aspects[i] == ASPECT_RED_YELLOW)
+            return true;
+    }
+    return false;
+}
+
+bool setCustomTimingPlan(uint8_t mode, const unsigned long *durations)
+{
+    if (mode > PLAN_FLASHING)
+        return false;
+    for (uint8_t i = 0; i < PHASE_COUNT; i++)
+    {
+        if (!durations[i])
+            continue;
+        if (showsYellow(PHASES[i]) ? durations[i] != PHASES[i].duration
+                                   : durations[i] < minimumPhaseTime(i) || durations[i] > MAXIMUM_PHASE_DURATION)
+            return false;
+    }
+
+    customPlan.mode = mode;
+    for (uint8_t i = 0; i < PHASE_COUNT; i++)
+        customPlan.durations[i] = durations[i];
+    Serial.println("Custom timing plan written");
+    return true;
+}
+
+const char *getStateName(TrafficLightState state)
+{
+    if ((uint8_t)state < PHASE_COUNT)
+        return PHASES[state].name;
+    return "UNKNOWN";
+}
+
+bool parseStateName(const char *name, TrafficLightState &state)
+{
+    for (uint8_t i = 0; i < PHASE_COUNT; i++)
+    {
+        if (strcmp(name, PHASES[i].name) == 0)
+        {
+            state = (TrafficLightState)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void getTrafficControllerSnapshot(TrafficControllerSnapshot &snapshot)
+{
+    snapshot.time = millis();
+    snapshot.state = currentState;
+    snapshot.sequenceStep = sequenceStep;
+    snapshot.pedestrianFlag = pedestrianFlag;
+    snapshot.vehicleFlag = vehicleFlag;
+    snapshot.stateStartTime = stateStartTime;
+    snapshot.activePlan = activePlan;
+    snapshot.pendingPlan = pendingPlan;
+    snapshot.preemptTarget = preemptTarget;
+    snapshot.preemptTime = preemptTime;
+    snapshot.customMode = customPlan.mode;
+    for (uint8_t i = 0; i < MAX_PHASES; i++)
+        snapshot.customDurations[i] = customPlan.durations[i];
+}
+
+void restoreTrafficControllerSnapshot(const TrafficControllerSnapshot &snapshot)
+{
+    currentState = (TrafficLightState)snapshot.state;
+    sequenceStep = snapshot.sequenceStep;
+    pedestrianFlag = snapshot.pedestrianFlag;
+    vehicleFlag = snapshot.vehicleFlag;
+    stateStartTime = snapshot.stateStartTime;
+    activePlan = snapshot.activePlan;
+    pendingPlan = snapshot.pendingPlan;
+    preemptTarget = snapshot.preemptTarget;
+    preemptTime = snapshot.preemptTime;
+    customPlan.mode = snapshot.customMode;
+    for (uint8_t i = 0; i < MAX_PHASES; i++)
+        customPlan.durations[i] = snapshot.customDurations[i];
+    setLights(currentState, true);
 }
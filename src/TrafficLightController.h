@@ -2,19 +2,7 @@
 #define TRAFFIC_LIGHT_CONTROLLER_H
 
 #include <Arduino.h>
-
-// Define the possible states for the traffic light system.
-enum TrafficLightState
-{
-    MAIN_GREEN,
-    MAIN_YELLOW,
-    ALL_RED,
-    SIDE_RED_YELLOW,
-    SIDE_GREEN,
-    SIDE_YELLOW,
-    MAIN_RED_YELLOW,
-    PEDESTRIAN_GREEN
-};
+#include "JunctionConfig.h"
 
 // Initialize the controller state machine.
 void initTrafficController();
@@ -26,7 +14,73 @@ void updateTrafficController();
 void handlePedestrianButton();
 void handleVehicleButton();
 
-// Function to set the traffic light state.
+// Switches to a phase (index into PHASES) right away and continues the cycle
+// from there. Returns false for an unknown phase and while preempted.
+bool setTrafficLightPhase(uint8_t phase);
+
+// Function to set the traffic light state by name.
+void setTrafficLightState(const char *state);
+#ifndef STRING_FREE
 void setTrafficLightState(const String &state);
+#endif
+
+// Emergency vehicle preemption: the controller takes the shortest legal path
+// to the requested green (see PhaseGraph.h), honouring yellow, red-yellow and
+// all-red times, holds it until released and then continues the normal cycle
+// from there. Returns false if the phase shows no vehicle green.
+bool requestPreemption(uint8_t phase);
+void releasePreemption();
+
+struct PreemptionStatus
+{
+    uint8_t target;        // Requested phase, NO_PHASE while not preempted
+    bool reached;          // The requested green is shown
+    unsigned long latency; // ms from the request until the green was shown, last preemption that got there
+};
+
+void getPreemptionStatus(PreemptionStatus &status);
+
+// Switches to another timing plan (index into TIMING_PLANS or CUSTOM_TIMING_PLAN) at the next cycle boundary.
+void requestTimingPlan(uint8_t plan);
+uint8_t getActiveTimingPlan();
+
+// Timing plan by index, TIMING_PLANS[] or the custom plan. NULL for unknown indices.
+const TimingPlan *getTimingPlan(uint8_t plan);
+
+// Writes the custom timing plan (CUSTOM_TIMING_PLAN), which starts out with
+// the PHASES[] durations. durations holds PHASE_COUNT entries, 0 keeps the
+// duration from PHASES[]. Only greens and all-red clearances can be changed:
+// their durations must lie between minimumPhaseTime() of the phase (see
+// PhaseGraph.h) and MAXIMUM_PHASE_DURATION, so a plan cannot shorten
+// clearance times. Phases showing yellow or red-yellow only accept their
+// PHASES[] duration. Returns false and leaves the plan unchanged otherwise.
+bool setCustomTimingPlan(uint8_t mode, const unsigned long *durations);
+
+// Returns the name of the state for display.
+const char *getStateName(TrafficLightState state);
+
+// Looks up a state by name. Returns false if the name is unknown.
+bool parseStateName(const char *name, TrafficLightState &state);
+
+// Internal state of the controller. Taken when a capture starts so that the
+// host replay can begin from exactly the same point.
+struct TrafficControllerSnapshot
+{
+    uint32_t time; // millis() when the snapshot was taken
+    uint8_t state;
+    uint8_t sequenceStep;
+    bool pedestrianFlag;
+    bool vehicleFlag;
+    uint8_t activePlan;
+    uint8_t pendingPlan;
+    uint32_t stateStartTime;
+    uint8_t preemptTarget; // NO_PHASE if not preempted
+    uint32_t preemptTime;  // millis() of the preemption request
+    uint8_t customMode;    // Custom timing plan, see setCustomTimingPlan()
+    uint32_t customDurations[MAX_PHASES];
+};
+
+void getTrafficControllerSnapshot(TrafficControllerSnapshot &snapshot);
+void restoreTrafficControllerSnapshot(const TrafficControllerSnapshot &snapshot);
 
 #endif // TRAFFIC_LIGHT_CONTROLLER_H
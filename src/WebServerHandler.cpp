@@ -1,356 +1,833 @@
 #include <WiFiNINA.h>
 #include "TrafficLightController.h"
+#include "InputRecorder.h"
+#include "WebServerHandler.h"
+#include "PlanScheduler.h"
+#include "JunctionConfig.h"
+#include "MemoryMonitor.h"
+#include "ImuReadings.h"
+#include "JsonWriter.h"
+#include "Commands.h"
 #include <Arduino_LSM6DS3.h>
 
+#ifdef STRING_FREE
+// Requests are handled in fixed buffers, any use of String is a compile error
+#pragma GCC poison String
+#endif
+
 extern WiFiServer server;
 extern TrafficLightState currentState; // Declared externally
 
-// Returns the name of the current state for display.
-const char *getStateName(TrafficLightState state)
+// Key for /preempt. There is no default, the board builds take it from the
+// PREEMPTION_KEY environment variable (see platformio.ini).
+#ifndef PREEMPTION_KEY
+#error "PREEMPTION_KEY is not defined, set the environment variable before building"
+#else
+static_assert(sizeof(PREEMPTION_KEY) > 1, "PREEMPTION_KEY must not be empty");
+#endif
+
+// Sends the /state response: the name of the current state as plain text
+void sendStateResponse(Print &client)
+{
+    client.println("HTTP/1.1 200 OK");
+    client.println("Content-Type: text/plain");
+    client.println("Connection: close");
+    client.println();
+    client.println(getStateName(currentState));
+}
+
+// Sends the /time response: clock and active timing plan as plain text
+void sendTimeResponse(Print &client)
+{
+    client.println("HTTP/1.1 200 OK");
+    client.println("Content-Type: text/plain");
+    client.println("Connection: close");
+    client.println();
+    if (clockIsSet())
+        printClock(client, getClock());
+    else
+        client.print("nicht gestellt");
+    client.print(" (Plan ");
+    client.print(getTimingPlan(getActiveTimingPlan())->name);
+    client.println(")");
+}
+
+// Sends a sensor reading in hundredths (0.01 g, 0.01 dps) as {"x":1.00,"y":-0.25,"z":0.00}
+void sendVectorResponse(Print &client, int32_t x, int32_t y, int32_t z)
+{
+    static const char HEADERS[] = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nConnection: close\r\n\r\n";
+    const size_t HEADER_LENGTH = sizeof(HEADERS) - 1;
+
+    // Longest body the sensors produce, the gyroscope at full scale (see ImuReadings.h)
+    static const char LONGEST_BODY[] = "{\"x\":-2000.00,\"y\":-2000.00,\"z\":-2000.00}";
+
+    // Headers and body in one write: one transfer to the WiFi module instead of eleven
+    char response[HEADER_LENGTH + 48];
+    static_assert(sizeof(response) - HEADER_LENGTH - 2 >= sizeof(LONGEST_BODY), "Response buffer too small");
+    memcpy(response, HEADERS, HEADER_LENGTH);
+    JsonWriter json(response + HEADER_LENGTH, sizeof(response) - HEADER_LENGTH - 2);
+    json.beginObject();
+    json.key("x");
+    json.fixed(x, 2);
+    json.key("y");
+    json.fixed(y, 2);
+    json.key("z");
+    json.fixed(z, 2);
+    json.endObject();
+    if (!json.ok())
+    {
+        // Values beyond the sensor range, better no answer than cut off JSON
+        client.println("HTTP/1.1 500 Internal Server Error");
+        client.println("Content-Type: text/plain");
+        client.println("Connection: close");
+        client.println();
+        client.println("Reading out of range");
+        return;
+    }
+
+    size_t length = HEADER_LENGTH + json.length();
+    response[length++] = '\r';
+    response[length++] = '\n';
+    client.write((const uint8_t *)response, length);
+}
+
+// Sends the outcome of a command (Commands.h) as plain text
+static void sendCommandResult(Print &client, CommandResult result)
 {
-    switch (state)
+    if (result == COMMAND_OK)
+        client.println("HTTP/1.1 200 OK");
+    else if (result == COMMAND_REFUSED)
+        client.println("HTTP/1.1 409 Conflict");
+    else
+        client.println("HTTP/1.1 400 Bad Request");
+    client.println("Content-Type: text/plain");
+    client.println("Connection: close");
+    client.println();
+    if (result == COMMAND_OK)
+        client.println("OK");
+    else if (result == COMMAND_REFUSED)
+        client.println("Refused");
+    else
+        client.println("Bad argument");
+}
+
+// Sends the /preempt response: preemption target, whether it is shown and the last latency
+static void sendPreemptionStatus(Print &client)
+{
+    PreemptionStatus status;
+    getPreemptionStatus(status);
+
+    client.println("HTTP/1.1 200 OK");
+    client.println("Content-Type: text/plain");
+    client.println("Connection: close");
+    client.println();
+    if (status.target == NO_PHASE)
+        client.print("NONE");
+    else
     {
-    case MAIN_GREEN:
-        return "MAIN_GREEN";
-    case MAIN_YELLOW:
-        return "MAIN_YELLOW";
-    case ALL_RED:
-        return "ALL_RED";
-    case SIDE_RED_YELLOW:
-        return "SIDE_RED_YELLOW";
-    case SIDE_GREEN:
-        return "SIDE_GREEN";
-    case SIDE_YELLOW:
-        return "SIDE_YELLOW";
-    case MAIN_RED_YELLOW:
-        return "MAIN_RED_YELLOW";
-    case PEDESTRIAN_GREEN:
-        return "PEDESTRIAN_GREEN";
-    default:
-        return "UNKNOWN";
+        client.print(getStateName((TrafficLightState)status.target));
+        client.print(status.reached ? " reached" : " pending");
     }
+    client.print(" (latency ");
+    client.print(status.latency);
+    client.println(" ms)");
 }
 
-// Handles incoming web requests
-void handleWebRequests()
+// Copies the value of query parameter name (without '=') up to the next '&'
+// or space into value, cut to size. Only whole parameter names match, and a
+// parameter without '=' has an empty value. Returns false (and an empty value)
+// if the parameter is missing.
+static bool queryValue(const char *request, const char *name, char *value, size_t size)
 {
-    WiFiClient client = server.available();
-    if (client)
+    value[0] = '\0';
+    const char *query = strchr(request, '?');
+    if (!query)
+        return false;
+    size_t nameLength = strlen(name);
+    const char *end = strchr(query, ' ');
+    if (!end)
+        end = query + strlen(query);
+
+    for (const char *start = query + 1; start < end;)
+    {
+        const char *next = start;
+        while (next < end && *next != '&')
+            next++;
+        if ((size_t)(next - start) >= nameLength && strncmp(start, name, nameLength) == 0 &&
+            (start + nameLength == next || start[nameLength] == '='))
+        {
+            start += nameLength;
+            if (start < next)
+                start++; // '='
+            size_t length = 0;
+            while (start + length < next && length < size - 1)
+            {
+                value[length] = start[length];
+                length++;
+            }
+            value[length] = '\0';
+            return true;
+        }
+        start = next + 1;
+    }
+    return false;
+}
+
+// Compares the whole key, so the time taken does not tell how much of it matched
+static bool preemptionKeyValid(const char *key)
+{
+    const char *expected = PREEMPTION_KEY;
+    size_t length = strlen(expected);
+    size_t keyLength = strlen(key);
+    uint8_t difference = keyLength != length;
+    for (size_t i = 0; i < length; i++)
+        difference |= (i < keyLength ? key[i] : 0) ^ expected[i];
+    return difference == 0;
+}
+
+// Main webpage with grid, state info, 3D gyro demo and raw sensor displays, one entry per line.
+// Kept as a table so that the page can be sent a few lines at a time.
+static const char *const DASHBOARD_LINES[] = {
+    "HTTP/1.1 200 OK",
+    "Content-Type: text/html",
+    "Connection: close",
+    "",
+    "<!DOCTYPE HTML>",
+    "<html>",
+    "<head>",
+    "  <meta charset='UTF-8'>",
+    "  <title>Verkehrsampel Status</title>",
+    "  <style>",
+    "    body { font-family: Arial, sans-serif; background-color: #f0f0f0; margin: 0; padding: 20px; }",
+    "    h1, h2 { text-align: center; }",
+    "    .grid-container {",
+    "      display: grid;",
+    "      grid-template-columns: repeat(3, 1fr);",
+    "      grid-template-rows: repeat(3, 1fr);",
+    "      grid-template-areas: ",
+    "        \". . A3\"",
+    "        \". . .\"",
+    "        \"A1 P A2\";",
+    "      gap: 10px;",
+    "      max-width: 600px;",
+    "      margin: auto;",
+    "    }",
+    "    .grid-item {",
+    "      border: 2px solid #ccc;",
+    "      border-radius: 5px;",
+    "      display: flex;",
+    "      align-items: center;",
+    "      justify-content: center;",
+    "      font-size: 1.5em;",
+    "      padding: 20px;",
+    "      box-shadow: 2px 2px 5px rgba(0,0,0,0.1);",
+    "      color: white;",
+    "    }",
+    "    .red { background-color: red; }",
+    "    .yellow { background-color: yellow; color: black; }",
+    "    .green { background-color: green; }",
+    "    .red-yellow {",
+    "      background: linear-gradient(to bottom, red, yellow);",
+    "      color: black;",
+    "    }",
+    // Style for the 3D gyroscope display
+    "    #gyroContainer { margin: 40px auto; width: 200px; height: 200px; background: #eee; perspective: 800px; display: none; }",
+    "    #gyroDisplay { width: 100%; height: 100%; background-color: #3498db; transform-style: preserve-3d; transition: transform 0.1s ease-out; }",
+    // Style for raw sensor values
+    "    #rawData { text-align: center; margin-top: 20px; font-size: 1.2em; display: none; }",
+    "    .sensor-toggle { text-align: center; margin: 20px 0; }",
+    "    .sensor-toggle label { cursor: pointer; }",
+    "  </style>",
+    "  <meta name='color-scheme' content='light only'>",
+    "</head>",
+    "<body>",
+    "  <h1>Verkehrsampel Status</h1>",
+    "  <div class='grid-container'>",
+    "    <div id='A3' class='grid-item' style='grid-area: A3;'>Ampel 3</div>",
+    "    <div id='A1' class='grid-item' style='grid-area: A1;'>Ampel 1</div>",
+    "    <div id='A2' class='grid-item' style='grid-area: A2;'>Ampel 2</div>",
+    "    <div id='P' class='grid-item' style='grid-area: P;'>Fußgänger</div>",
+    "  </div>",
+    "  <p style='text-align:center; margin-top:20px;'>",
+    "    Aktueller Zustand: <span id='state'>Lädt...</span>",
+    "  </p>",
+    // Clock and timing plan, the button sets the board clock from the browser
+    "  <p style='text-align:center;'>",
+    "    Uhrzeit: <span id='clock'>Lädt...</span>",
+    "    <button onclick='setClock()'>Uhr stellen</button>",
+    "  </p>",
+    // Dropdown for state selection and button to set the state
+    "  <div style='text-align:center; margin-top:20px;'>",
+    "    <select id='stateSelect'>",
+    "      <option value='MAIN_GREEN'>MAIN_GREEN</option>",
+    "      <option value='MAIN_YELLOW'>MAIN_YELLOW</option>",
+    "      <option value='ALL_RED'>ALL_RED</option>",
+    "      <option value='SIDE_RED_YELLOW'>SIDE_RED_YELLOW</option>",
+    "      <option value='SIDE_GREEN'>SIDE_GREEN</option>",
+    "      <option value='SIDE_YELLOW'>SIDE_YELLOW</option>",
+    "      <option value='MAIN_RED_YELLOW'>MAIN_RED_YELLOW</option>",
+    "      <option value='PEDESTRIAN_GREEN'>PEDESTRIAN_GREEN</option>",
+    "    </select>",
+    "    <button onclick='setState()'>Set State</button>",
+    "  </div>",
+
+    // Add checkbox to toggle gyro display
+    "  <div class='sensor-toggle'>",
+    "    <label>",
+    "      <input type='checkbox' id='showGyroData' onclick='toggleGyroData()'>",
+    "      Zeige Extra",
+    "    </label>",
+    "  </div>",
+
+    // 3D Gyroscope display element
+    "  <h2>Drehung</h2>",
+    "  <div id='gyroContainer'>",
+    "    <div id='gyroDisplay'></div>",
+    "  </div>",
+    // Raw sensor values display
+    "  <div id='rawData'>",
+    "    <p id='gyroRaw'>Gyro Raw: Loading...</p>",
+    "    <p id='accelRaw'>Accel Raw: Loading...</p>",
+    "  </div>",
+    // JavaScript for fetching state and sensor data
+    "  <script>",
+    "    function updateColors(state) {",
+    "      const colors = {",
+    "        MAIN_GREEN: { A1: 'green', A2: 'red', A3: 'green', P: 'red' },",
+    "        MAIN_YELLOW: { A1: 'yellow', A2: 'red', A3: 'yellow', P: 'red' },",
+    "        ALL_RED: { A1: 'red', A2: 'red', A3: 'red', P: 'red' },",
+    "        SIDE_RED_YELLOW: { A1: 'red', A2: 'red-yellow', A3: 'red', P: 'red' },",
+    "        SIDE_GREEN: { A1: 'red', A2: 'green', A3: 'red', P: 'red' },",
+    "        SIDE_YELLOW: { A1: 'red', A2: 'yellow', A3: 'red', P: 'red' },",
+    "        MAIN_RED_YELLOW: { A1: 'red-yellow', A2: 'red', A3: 'red-yellow', P: 'red' },",
+    "        PEDESTRIAN_GREEN: { A1: 'red', A2: 'red', A3: 'red', P: 'green' },",
+    "        FLASHING_YELLOW: { A1: 'yellow', A2: 'yellow', A3: 'yellow', P: '' }",
+    "      };",
+    "      const colorMap = colors[state] || { A1: 'red', A2: 'red', A3: 'red', P: 'red' };",
+    "      document.getElementById('A1').className = 'grid-item ' + colorMap.A1;",
+    "      document.getElementById('A2').className = 'grid-item ' + colorMap.A2;",
+    "      document.getElementById('A3').className = 'grid-item ' + colorMap.A3;",
+    "      document.getElementById('P').className  = 'grid-item ' + colorMap.P;",
+    "    }",
+    "    async function fetchState() {",
+    "      const response = await fetch('/state');",
+    "      let state = await response.text();",
+    "      state = state.trim();",
+    "      document.getElementById('state').innerText = 'Aktueller Zustand: ' + state;",
+    "      updateColors(state);",
+    "    }",
+    "    async function fetchGyro() {",
+    "      try {",
+    "        const response = await fetch('/gyro');",
+    "        if(response.ok) {",
+    "          const data = await response.json();",
+    "          // Update the 3D rotation based on gyro values",
+    "          document.getElementById('gyroDisplay').style.transform = ",
+    "            `rotateX(${data.x}deg) rotateY(${data.y}deg) rotateZ(${data.z}deg)`;",
+    "          // Update raw gyro display",
+    "          document.getElementById('gyroRaw').innerText = ",
+    "            `Gyro Raw: x=${data.x.toFixed(2)} dps, y=${data.y.toFixed(2)} dps, z=${data.z.toFixed(2)} dps`;",
+    "        }",
+    "      } catch (error) {",
+    "        console.error('Error fetching gyro data:', error);",
+    "      }",
+    "    }",
+    "    async function fetchAccel() {",
+    "      try {",
+    "        const response = await fetch('/accel');",
+    "        if(response.ok) {",
+    "          const data = await response.json();",
+    "          // Update raw acceleration display",
+    "          document.getElementById('accelRaw').innerText = ",
+    "            `Accel Raw: x=${data.x.toFixed(2)} g, y=${data.y.toFixed(2)} g, z=${data.z.toFixed(2)} g`;",
+    "        }",
+    "      } catch (error) {",
+    "        console.error('Error fetching accel data:', error);",
+    "      }",
+    "    }",
+    "    async function setState() {",
+    "      const select = document.getElementById('stateSelect');",
+    "      const newState = select.value;",
+    "      await fetch(`/set?state=${newState}`);",
+    "      fetchState();",
+    "    }",
+    "    async function fetchClock() {",
+    "      const response = await fetch('/time');",
+    "      document.getElementById('clock').innerText = (await response.text()).trim();",
+    "    }",
+    "    async function setClock() {",
+    "      // Local time as seconds since 1970, the board has no time zone",
+    "      const now = new Date();",
+    "      const local = Math.floor(now.getTime() / 1000) - now.getTimezoneOffset() * 60;",
+    "      await fetch(`/time?set=${local}`);",
+    "      fetchClock();",
+    "    }",
+
+    "    // Sensor data intervals",
+    "    let gyroInterval = null;",
+    "    let accelInterval = null;",
+
+    "    function toggleGyroData() {",
+    "      const checked = document.getElementById('showGyroData').checked;",
+    "      const gyroContainer = document.getElementById('gyroContainer');",
+    "      const rawData = document.getElementById('rawData');",
+    "      ",
+    "      // Toggle visibility",
+    "      gyroContainer.style.display = checked ? 'block' : 'none';",
+    "      rawData.style.display = checked ? 'block' : 'none';",
+    "      ",
+    "      // Toggle data fetching",
+    "      if (checked) {",
+    "        // Initial fetch to show data immediately",
+    "        fetchGyro();",
+    "        fetchAccel();",
+    "        // Start intervals",
+    "        gyroInterval = setInterval(fetchGyro, 1000);",
+    "        accelInterval = setInterval(fetchAccel, 1000);",
+    "      } else {",
+    "        // Clear intervals",
+    "        clearInterval(gyroInterval);",
+    "        clearInterval(accelInterval);",
+    "        gyroInterval = null;",
+    "        accelInterval = null;",
+    "      }",
+    "    }",
+
+    "    setInterval(fetchState, 500);",
+    "    fetchClock();",
+    "    setInterval(fetchClock, 5000);",
+    "  </script>",
+    "</body>",
+    "</html>"};
+
+const uint16_t DASHBOARD_LINE_COUNT = sizeof(DASHBOARD_LINES) / sizeof(DASHBOARD_LINES[0]);
+
+// Bytes of dashboard lines collected for one write
+const size_t DASHBOARD_PIECE_SIZE = 512;
+
+// Writes as many dashboard lines from position on as fit into one piece, in
+// one transfer to the WiFi module. Returns the position after them.
+static uint16_t writeDashboardPiece(Print &client, uint16_t position)
+{
+    char piece[DASHBOARD_PIECE_SIZE];
+    size_t length = 0;
+    while (position < DASHBOARD_LINE_COUNT)
     {
-        String request = client.readStringUntil('\r');
-        client.flush();
+        const char *line = DASHBOARD_LINES[position];
+        size_t lineLength = strlen(line);
+        if (length + lineLength + 2 > sizeof(piece))
+            break;
+        memcpy(piece + length, line, lineLength);
+        length += lineLength;
+        piece[length++] = '\r';
+        piece[length++] = '\n';
+        position++;
+    }
+
+    // A line longer than a piece goes out on its own
+    if (length == 0)
+        client.println(DASHBOARD_LINES[position++]);
+    else
+        client.write((const uint8_t *)piece, length);
+    return position;
+}
+
+// Sends the main webpage in one go
+void sendDashboard(Print &client)
+{
+    for (uint16_t i = 0; i < DASHBOARD_LINE_COUNT;)
+        i = writeDashboardPiece(client, i);
+}
+
+// --- Connections ---
+// Responses are written a piece at a time so that a long page or a slow
+// browser never holds up the traffic light: each handleWebRequests() pass
+// writes for at most WEB_TIME_SLICE_US and continues on the next pass.
+
+const uint8_t MAX_CONNECTIONS = 2;
+const unsigned long WEB_TIME_SLICE_US = 2000;   // Writing time per loop pass
+const unsigned long REQUEST_TIMEOUT_MS = 1000;  // Drop clients that do not send a request line
+const uint8_t REQUEST_LINE_SIZE = 128;          // Longer request lines are cut off
+
+enum ConnectionState : uint8_t
+{
+    CONNECTION_FREE,
+    CONNECTION_READING, // Waiting for the request line
+    CONNECTION_WRITING  // Sending a long response
+};
+
+enum LongResponse : uint8_t
+{
+    RESPONSE_DASHBOARD,
+    RESPONSE_CAPTURE
+};
+
+struct Connection
+{
+    WiFiClient client;
+    uint8_t state; // ConnectionState
+    char request[REQUEST_LINE_SIZE];
+    uint8_t requestLength;
+    unsigned long openedAt;
+    uint8_t response;  // LongResponse
+    uint16_t position; // Next piece of the response
+    size_t eventCount; // Events in the capture when the download started
+};
 
-        // Serve gyroscope data: returns JSON with x, y, z values
-        if (request.indexOf("/gyro") != -1)
+static Connection connections[MAX_CONNECTIONS];
+
+// Collects the request line without blocking. Returns true once it is complete.
+static bool readRequestLine(Connection &connection)
+{
+    while (connection.client.available())
+    {
+        int c = connection.client.read();
+        if (c < 0)
+            break;
+        if (c == '\r' || c == '\n')
         {
-            float gx = 0, gy = 0, gz = 0;
-            if (IMU.gyroscopeAvailable())
+            connection.request[connection.requestLength] = '\0';
+            return true;
+        }
+        if (connection.requestLength < REQUEST_LINE_SIZE - 1)
+            connection.request[connection.requestLength++] = c;
+    }
+    return false;
+}
+
+// Throws away what the client sent after the request line, the headers are
+// not needed. flush() does not do this on WiFiNINA, and as long as a client has
+// unread data server.available() keeps returning it, so no other client would
+// get a free slot while its response is written.
+static void discardInput(WiFiClient &client)
+{
+    uint8_t buffer[64];
+    int count = client.available();
+    while (count > 0)
+    {
+        int length = client.read(buffer, count < (int)sizeof(buffer) ? count : sizeof(buffer));
+        if (length <= 0)
+            break;
+        count -= length;
+    }
+}
+
+// Answers the request. Short responses are sent right away; for the long ones
+// only the response is chosen. Returns true if the response is complete.
+static bool startResponse(Connection &connection)
+{
+    WiFiClient &client = connection.client;
+    const char *request = connection.request;
+    connection.position = 0;
+
+    // Serve gyroscope data: returns JSON with x, y, z values
+    if (strstr(request, "/gyro"))
+    {
+        ImuCounts counts;
+        if (IMU.gyroscopeAvailable())
+        {
+            if (readRawGyroscope(counts))
             {
-                if (IMU.readGyroscope(gx, gy, gz))
-                {
-                    client.println("HTTP/1.1 200 OK");
-                    client.println("Content-Type: application/json");
-                    client.println("Connection: close");
-                    client.println();
-                    client.print("{\"x\":");
-                    client.print(gx, 2);
-                    client.print(",\"y\":");
-                    client.print(gy, 2);
-                    client.print(",\"z\":");
-                    client.print(gz, 2);
-                    client.println("}");
-                }
-                else
-                {
-                    client.println("HTTP/1.1 500 Internal Server Error");
-                    client.println("Content-Type: text/plain");
-                    client.println("Connection: close");
-                    client.println();
-                    client.println("Gyroscope read error");
-                }
+                sendVectorResponse(client, rotationCentiDps(counts.x), rotationCentiDps(counts.y), rotationCentiDps(counts.z));
             }
             else
             {
-                client.println("HTTP/1.1 503 Service Unavailable");
+                client.println("HTTP/1.1 500 Internal Server Error");
                 client.println("Content-Type: text/plain");
                 client.println("Connection: close");
                 client.println();
-                client.println("Gyroscope not available");
+                client.println("Gyroscope read error");
             }
         }
-        // Serve accelerometer data: returns JSON with x, y, z values
-        else if (request.indexOf("/accel") != -1)
+        else
         {
-            float ax = 0, ay = 0, az = 0;
-            if (IMU.accelerationAvailable())
+            client.println("HTTP/1.1 503 Service Unavailable");
+            client.println("Content-Type: text/plain");
+            client.println("Connection: close");
+            client.println();
+            client.println("Gyroscope not available");
+        }
+    }
+    // Serve accelerometer data: returns JSON with x, y, z values
+    else if (strstr(request, "/accel"))
+    {
+        ImuCounts counts;
+        if (IMU.accelerationAvailable())
+        {
+            if (readRawAcceleration(counts))
             {
-                if (IMU.readAcceleration(ax, ay, az))
-                {
-                    client.println("HTTP/1.1 200 OK");
-                    client.println("Content-Type: application/json");
-                    client.println("Connection: close");
-                    client.println();
-                    client.print("{\"x\":");
-                    client.print(ax, 2);
-                    client.print(",\"y\":");
-                    client.print(ay, 2);
-                    client.print(",\"z\":");
-                    client.print(az, 2);
-                    client.println("}");
-                }
-                else
-                {
-                    client.println("HTTP/1.1 500 Internal Server Error");
-                    client.println("Content-Type: text/plain");
-                    client.println("Connection: close");
-                    client.println();
-                    client.println("Accelerometer read error");
-                }
+                sendVectorResponse(client, accelerationCentiG(counts.x), accelerationCentiG(counts.y), accelerationCentiG(counts.z));
             }
             else
             {
-                client.println("HTTP/1.1 503 Service Unavailable");
+                client.println("HTTP/1.1 500 Internal Server Error");
                 client.println("Content-Type: text/plain");
                 client.println("Connection: close");
                 client.println();
-                client.println("Accelerometer not available");
+                client.println("Accelerometer read error");
             }
         }
-        // Serve current state
-        else if (request.indexOf("/state") != -1)
+        else
         {
-            client.println("HTTP/1.1 200 OK");
+            client.println("HTTP/1.1 503 Service Unavailable");
             client.println("Content-Type: text/plain");
             client.println("Connection: close");
             client.println();
-            client.println(getStateName(currentState));
+            client.println("Accelerometer not available");
         }
-        // Set new state via AJAX
-        else if (request.indexOf("/set") != -1)
+    }
+    // Emergency vehicle preemption: /preempt?key=<key>&phase=<state> requests it,
+    // /preempt?key=<key>&release ends it, /preempt alone only reports the status
+    else if (strstr(request, "/preempt"))
+    {
+        char release[1];
+        char phase[24];
+        char key[sizeof(PREEMPTION_KEY) + 1]; // One more character than the key, a longer one does not match
+        bool releasing = queryValue(request, "release", release, sizeof(release));
+        queryValue(request, "phase", phase, sizeof(phase));
+        queryValue(request, "key", key, sizeof(key));
+        if ((releasing || phase[0]) && !preemptionKeyValid(key))
         {
-            int idx = request.indexOf("state=");
-            if (idx != -1)
-            {
-                int startIdx = idx + 6;                      // Start after "state="
-                int endIdx = request.indexOf(' ', startIdx); // Find the space before HTTP/1.1
-                if (endIdx == -1)
-                {
-                    endIdx = request.length(); // If no space found, take the rest of the string
-                }
-                String newState = request.substring(startIdx, endIdx);
-                newState.trim(); // Remove any extra whitespace
-                Serial.print("Setting state to: ");
-                Serial.println(newState);
-                setTrafficLightState(newState); // Function defined in TrafficLightController.h
-            }
-            client.println("HTTP/1.1 200 OK");
+            client.println("HTTP/1.1 403 Forbidden");
             client.println("Content-Type: text/plain");
             client.println("Connection: close");
             client.println();
-            client.println("OK");
+            client.println("Wrong key");
+            return true;
         }
-        // Ignore favicon requests
-        else if (request.indexOf("/favicon.ico") != -1)
+
+        TrafficLightState target;
+        if (releasing)
+            commandReleasePreemption();
+        else if (phase[0] && (!parseStateName(phase, target) || commandPreempt(target) != COMMAND_OK))
         {
-            client.stop();
-            return;
+            client.println("HTTP/1.1 400 Bad Request");
+            client.println("Content-Type: text/plain");
+            client.println("Connection: close");
+            client.println();
+            client.println("Not a vehicle green");
+            return true;
+        }
+        sendPreemptionStatus(client);
+    }
+    // RAM usage, see MemoryMonitor.h
+    else if (strstr(request, "/memory"))
+    {
+        client.println("HTTP/1.1 200 OK");
+        client.println("Content-Type: text/plain");
+        client.println("Connection: close");
+        client.println();
+        printMemoryReport(client);
+    }
+    // Serve current state
+    else if (strstr(request, "/state"))
+    {
+        sendStateResponse(client);
+    }
+    // Read or set the clock: /time?set=<local seconds since 1970>
+    else if (strstr(request, "/time"))
+    {
+        char set[12]; // Ten digits and one more to notice longer values
+        if (queryValue(request, "set", set, sizeof(set)))
+        {
+            char *end;
+            unsigned long epoch = strtoul(set, &end, 10);
+            bool number = set[0] >= '0' && set[0] <= '9' && *end == '\0' && end - set <= 10;
+            CommandResult result = number ? commandSetClock(epoch) : COMMAND_BAD_ARGUMENT;
+            if (result != COMMAND_OK)
+            {
+                sendCommandResult(client, result);
+                return true;
+            }
         }
-        // Serve main webpage with grid, state info, 3D gyro demo and raw sensor displays
+        sendTimeResponse(client);
+    }
+    // Hold a timing plan: /plan?select=<index> or /plan?select=custom (written over the
+    // supervisory link), back to the schedule with /plan?select=auto
+    else if (strstr(request, "/plan"))
+    {
+        char select[8]; // A value that fills it may have been cut
+        queryValue(request, "select", select, sizeof(select));
+        char *end;
+        unsigned long index = strtoul(select, &end, 10);
+        CommandResult result = COMMAND_BAD_ARGUMENT;
+        if (strcmp(select, "auto") == 0)
+            result = commandSelectTimingPlan(FOLLOW_SCHEDULE);
+        else if (strcmp(select, "custom") == 0)
+            result = commandSelectTimingPlan(CUSTOM_TIMING_PLAN);
+        else if (select[0] >= '0' && select[0] <= '9' && *end == '\0' && end - select < 7 && index <= UINT8_MAX)
+            result = commandSelectTimingPlan(index);
+        if (result == COMMAND_OK)
+            sendTimeResponse(client);
         else
+            sendCommandResult(client, result);
+    }
+    // Set new state via AJAX
+    else if (strstr(request, "/set"))
+    {
+        char newState[24];
+        CommandResult result = COMMAND_OK;
+        if (queryValue(request, "state", newState, sizeof(newState))) // Up to the space before HTTP/1.1
         {
-            client.println("HTTP/1.1 200 OK");
-            client.println("Content-Type: text/html");
-            client.println("Connection: close");
-            client.println();
-            client.println("<!DOCTYPE HTML>");
-            client.println("<html>");
-            client.println("<head>");
-            client.println("  <meta charset='UTF-8'>");
-            client.println("  <title>Verkehrsampel Status</title>");
-            client.println("  <style>");
-            client.println("    body { font-family: Arial, sans-serif; background-color: #f0f0f0; margin: 0; padding: 20px; }");
-            client.println("    h1, h2 { text-align: center; }");
-            client.println("    .grid-container {");
-            client.println("      display: grid;");
-            client.println("      grid-template-columns: repeat(3, 1fr);");
-            client.println("      grid-template-rows: repeat(3, 1fr);");
-            client.println("      grid-template-areas: ");
-            client.println("        \". . A3\"");
-            client.println("        \". . .\"");
-            client.println("        \"A1 P A2\";");
-            client.println("      gap: 10px;");
-            client.println("      max-width: 600px;");
-            client.println("      margin: auto;");
-            client.println("    }");
-            client.println("    .grid-item {");
-            client.println("      border: 2px solid #ccc;");
-            client.println("      border-radius: 5px;");
-            client.println("      display: flex;");
-            client.println("      align-items: center;");
-            client.println("      justify-content: center;");
-            client.println("      font-size: 1.5em;");
-            client.println("      padding: 20px;");
-            client.println("      box-shadow: 2px 2px 5px rgba(0,0,0,0.1);");
-            client.println("      color: white;");
-            client.println("    }");
-            client.println("    .red { background-color: red; }");
-            client.println("    .yellow { background-color: yellow; color: black; }");
-            client.println("    .green { background-color: green; }");
-            client.println("    .red-yellow {");
-            client.println("      background: linear-gradient(to bottom, red, yellow);");
-            client.println("      color: black;");
-            client.println("    }");
-            // Style for the 3D gyroscope display
-            client.println("    #gyroContainer { margin: 40px auto; width: 200px; height: 200px; background: #eee; perspective: 800px; display: none; }");
-            client.println("    #gyroDisplay { width: 100%; height: 100%; background-color: #3498db; transform-style: preserve-3d; transition: transform 0.1s ease-out; }");
-            // Style for raw sensor values
-            client.println("    #rawData { text-align: center; margin-top: 20px; font-size: 1.2em; display: none; }");
-            client.println("    .sensor-toggle { text-align: center; margin: 20px 0; }");
-            client.println("    .sensor-toggle label { cursor: pointer; }");
-            client.println("  </style>");
-            client.println("  <meta name='color-scheme' content='light only'>");
-            client.println("</head>");
-            client.println("<body>");
-            client.println("  <h1>Verkehrsampel Status</h1>");
-            client.println("  <div class='grid-container'>");
-            client.println("    <div id='A3' class='grid-item' style='grid-area: A3;'>Ampel 3</div>");
-            client.println("    <div id='A1' class='grid-item' style='grid-area: A1;'>Ampel 1</div>");
-            client.println("    <div id='A2' class='grid-item' style='grid-area: A2;'>Ampel 2</div>");
-            client.println("    <div id='P' class='grid-item' style='grid-area: P;'>Fußgänger</div>");
-            client.println("  </div>");
-            client.println("  <p style='text-align:center; margin-top:20px;'>");
-            client.println("    Aktueller Zustand: <span id='state'>Lädt...</span>");
-            client.println("  </p>");
-            // Dropdown for state selection and button to set the state
-            client.println("  <div style='text-align:center; margin-top:20px;'>");
-            client.println("    <select id='stateSelect'>");
-            client.println("      <option value='MAIN_GREEN'>MAIN_GREEN</option>");
-            client.println("      <option value='MAIN_YELLOW'>MAIN_YELLOW</option>");
-            client.println("      <option value='ALL_RED'>ALL_RED</option>");
-            client.println("      <option value='SIDE_RED_YELLOW'>SIDE_RED_YELLOW</option>");
-            client.println("      <option value='SIDE_GREEN'>SIDE_GREEN</option>");
-            client.println("      <option value='SIDE_YELLOW'>SIDE_YELLOW</option>");
-            client.println("      <option value='MAIN_RED_YELLOW'>MAIN_RED_YELLOW</option>");
-            client.println("      <option value='PEDESTRIAN_GREEN'>PEDESTRIAN_GREEN</option>");
-            client.println("    </select>");
-            client.println("    <button onclick='setState()'>Set State</button>");
-            client.println("  </div>");
-
-            // Add checkbox to toggle gyro display
-            client.println("  <div class='sensor-toggle'>");
-            client.println("    <label>");
-            client.println("      <input type='checkbox' id='showGyroData' onclick='toggleGyroData()'>");
-            client.println("      Zeige Extra");
-            client.println("    </label>");
-            client.println("  </div>");
-
-            // 3D Gyroscope display element
-            client.println("  <h2>Drehung</h2>");
-            client.println("  <div id='gyroContainer'>");
-            client.println("    <div id='gyroDisplay'></div>");
-            client.println("  </div>");
-            // Raw sensor values display
-            client.println("  <div id='rawData'>");
-            client.println("    <p id='gyroRaw'>Gyro Raw: Loading...</p>");
-            client.println("    <p id='accelRaw'>Accel Raw: Loading...</p>");
-            client.println("  </div>");
-            // JavaScript for fetching state and sensor data
-            client.println("  <script>");
-            client.println("    function updateColors(state) {");
-            client.println("      const colors = {");
-            client.println("        MAIN_GREEN: { A1: 'green', A2: 'red', A3: 'green', P: 'red' },");
-            client.println("        MAIN_YELLOW: { A1: 'yellow', A2: 'red', A3: 'yellow', P: 'red' },");
-            client.println("        ALL_RED: { A1: 'red', A2: 'red', A3: 'red', P: 'red' },");
-            client.println("        SIDE_RED_YELLOW: { A1: 'red', A2: 'red-yellow', A3: 'red', P: 'red' },");
-            client.println("        SIDE_GREEN: { A1: 'red', A2: 'green', A3: 'red', P: 'red' },");
-            client.println("        SIDE_YELLOW: { A1: 'red', A2: 'yellow', A3: 'red', P: 'red' },");
-            client.println("        MAIN_RED_YELLOW: { A1: 'red-yellow', A2: 'red', A3: 'red-yellow', P: 'red' },");
-            client.println("        PEDESTRIAN_GREEN: { A1: 'red', A2: 'red', A3: 'red', P: 'green' }");
-            client.println("      };");
-            client.println("      const colorMap = colors[state] || { A1: 'red', A2: 'red', A3: 'red', P: 'red' };");
-            client.println("      document.getElementById('A1').className = 'grid-item ' + colorMap.A1;");
-            client.println("      document.getElementById('A2').className = 'grid-item ' + colorMap.A2;");
-            client.println("      document.getElementById('A3').className = 'grid-item ' + colorMap.A3;");
-            client.println("      document.getElementById('P').className  = 'grid-item ' + colorMap.P;");
-            client.println("    }");
-            client.println("    async function fetchState() {");
-            client.println("      const response = await fetch('/state');");
-            client.println("      let state = await response.text();");
-            client.println("      state = state.trim();");
-            client.println("      document.getElementById('state').innerText = 'Aktueller Zustand: ' + state;");
-            client.println("      updateColors(state);");
-            client.println("    }");
-            client.println("    async function fetchGyro() {");
-            client.println("      try {");
-            client.println("        const response = await fetch('/gyro');");
-            client.println("        if(response.ok) {");
-            client.println("          const data = await response.json();");
-            client.println("          // Update the 3D rotation based on gyro values");
-            client.println("          document.getElementById('gyroDisplay').style.transform = ");
-            client.println("            `rotateX(${data.x}deg) rotateY(${data.y}deg) rotateZ(${data.z}deg)`;");
-            client.println("          // Update raw gyro display");
-            client.println("          document.getElementById('gyroRaw').innerText = ");
-            client.println("            `Gyro Raw: x=${data.x.toFixed(2)} dps, y=${data.y.toFixed(2)} dps, z=${data.z.toFixed(2)} dps`;");
-            client.println("        }");
-            client.println("      } catch (error) {");
-            client.println("        console.error('Error fetching gyro data:', error);");
-            client.println("      }");
-            client.println("    }");
-            client.println("    async function fetchAccel() {");
-            client.println("      try {");
-            client.println("        const response = await fetch('/accel');");
-            client.println("        if(response.ok) {");
-            client.println("          const data = await response.json();");
-            client.println("          // Update raw acceleration display");
-            client.println("          document.getElementById('accelRaw').innerText = ");
-            client.println("            `Accel Raw: x=${data.x.toFixed(2)} g, y=${data.y.toFixed(2)} g, z=${data.z.toFixed(2)} g`;");
-            client.println("        }");
-            client.println("      } catch (error) {");
-            client.println("        console.error('Error fetching accel data:', error);");
-            client.println("      }");
-            client.println("    }");
-            client.println("    async function setState() {");
-            client.println("      const select = document.getElementById('stateSelect');");
-            client.println("      const newState = select.value;");
-            client.println("      await fetch(`/set?state=${newState}`);");
-            client.println("      fetchState();");
-            client.println("    }");
-
-            client.println("    // Sensor data intervals");
-            client.println("    let gyroInterval = null;");
-            client.println("    let accelInterval = null;");
-
-            client.println("    function toggleGyroData() {");
-            client.println("      const checked = document.getElementById('showGyroData').checked;");
-            client.println("      const gyroContainer = document.getElementById('gyroContainer');");
-            client.println("      const rawData = document.getElementById('rawData');");
-            client.println("      ");
-            client.println("      // Toggle visibility");
-            client.println("      gyroContainer.style.display = checked ? 'block' : 'none';");
-            client.println("      rawData.style.display = checked ? 'block' : 'none';");
-            client.println("      ");
-            client.println("      // Toggle data fetching");
-            client.println("      if (checked) {");
-            client.println("        // Initial fetch to show data immediately");
-            client.println("        fetchGyro();");
-            client.println("        fetchAccel();");
-            client.println("        // Start intervals");
-            client.println("        gyroInterval = setInterval(fetchGyro, 1000);");
-            client.println("        accelInterval = setInterval(fetchAccel, 1000);");
-            client.println("      } else {");
-            client.println("        // Clear intervals");
-            client.println("        clearInterval(gyroInterval);");
-            client.println("        clearInterval(accelInterval);");
-            client.println("        gyroInterval = null;");
-            client.println("        accelInterval = null;");
-            client.println("      }");
-            client.println("    }");
-
-            client.println("    setInterval(fetchState, 500);");
-            client.println("  </script>");
-            client.println("</body>");
-            client.println("</html>");
+            TrafficLightState state;
+            result = parseStateName(newState, state) ? commandSetState(state) : COMMAND_BAD_ARGUMENT;
         }
-        client.stop();
+        sendCommandResult(client, result);
+    }
+    // Input capture for host replay: start, stop and download
+    else if (strstr(request, "/capture/start"))
+    {
+        sendCommandResult(client, commandStartCapture());
+    }
+    else if (strstr(request, "/capture/stop"))
+    {
+        sendCommandResult(client, commandStopCapture());
+    }
+    // The capture and the main webpage are long, they are sent by continueResponse()
+    else if (strstr(request, "/capture"))
+    {
+        connection.response = RESPONSE_CAPTURE;
+        connection.eventCount = recordedEventCount();
+        return false;
+    }
+    // Ignore favicon requests
+    else if (strstr(request, "/favicon.ico"))
+    {
+        // Nothing to send, just close the connection
+    }
+    // Serve main webpage with grid, state info, 3D gyro demo and raw sensor displays
+    else
+    {
+        connection.response = RESPONSE_DASHBOARD;
+        return false;
+    }
+    return true;
+}
+
+// Writes the next piece of a long response. Returns true once it is complete.
+static bool continueResponse(Connection &connection)
+{
+    WiFiClient &client = connection.client;
+    if (connection.response == RESPONSE_DASHBOARD)
+    {
+        connection.position = writeDashboardPiece(client, connection.position);
+        return connection.position >= DASHBOARD_LINE_COUNT;
+    }
+
+    uint16_t position = connection.position++;
+
+    // Capture: HTTP header, capture header, the events, then the footer
+    if (position == 0)
+    {
+        client.println("HTTP/1.1 200 OK");
+        client.println("Content-Type: text/plain");
+        client.println("Content-Disposition: attachment; filename=capture.txt");
+        client.println("Connection: close");
+        client.println();
+    }
+    else if (position == 1)
+        printRecordingHeader(client);
+    else if (position - 2U < connection.eventCount)
+        printRecordedEvent(client, position - 2);
+    else
+    {
+        printRecordingFooter(client, connection.eventCount);
+        return true;
+    }
+    return false;
+}
+
+static void closeConnection(Connection &connection)
+{
+    connection.client.stop();
+    connection.state = CONNECTION_FREE;
+}
+
+// Takes a waiting client into a free slot. While all slots are busy the client
+// stays queued in the WiFi module.
+static void acceptClient()
+{
+    WiFiClient client = server.available();
+    if (!client)
+        return;
+
+    // available() also returns clients that already have a slot
+    for (uint8_t i = 0; i < MAX_CONNECTIONS; i++)
+    {
+        if (connections[i].state != CONNECTION_FREE && connections[i].client == client)
+            return;
+    }
+
+    for (uint8_t i = 0; i < MAX_CONNECTIONS; i++)
+    {
+        Connection &connection = connections[i];
+        if (connection.state == CONNECTION_FREE)
+        {
+            connection.client = client;
+            connection.state = CONNECTION_READING;
+            connection.requestLength = 0;
+            connection.openedAt = millis();
+            return;
+        }
+    }
+}
+
+static void serviceConnection(Connection &connection, unsigned long sliceStart)
+{
+    if (connection.state == CONNECTION_READING)
+    {
+        if (readRequestLine(connection))
+        {
+            discardInput(connection.client);
+            if (startResponse(connection))
+                closeConnection(connection);
+            else
+                connection.state = CONNECTION_WRITING;
+        }
+        else if (millis() - connection.openedAt > REQUEST_TIMEOUT_MS || !connection.client.connected())
+        {
+            closeConnection(connection);
+        }
+        return;
+    }
+
+    // Writing: pieces while the time slice has room for another one as long as the last
+    if (!connection.client.connected())
+    {
+        closeConnection(connection);
+        return;
+    }
+    discardInput(connection.client); // Headers that arrived after the request line
+    unsigned long pieceTime = 0;
+    for (;;)
+    {
+        unsigned long pieceStart = micros();
+        if (pieceStart - sliceStart + pieceTime > WEB_TIME_SLICE_US)
+            return;
+        bool complete = continueResponse(connection);
+        pieceTime = micros() - pieceStart;
+        if (complete)
+        {
+            closeConnection(connection);
+            return;
+        }
+    }
+}
+
+// Handles incoming web requests. Call this function in loop(); the writing
+// stops within WEB_TIME_SLICE_US. The connections take turns going first, so
+// a long response cannot use up every slice.
+void handleWebRequests()
+{
+    static uint8_t first = 0;
+    acceptClient();
+
+    unsigned long sliceStart = micros();
+    for (uint8_t i = 0; i < MAX_CONNECTIONS; i++)
+    {
+        Connection &connection = connections[(first + i) % MAX_CONNECTIONS];
+        if (connection.state != CONNECTION_FREE)
+            serviceConnection(connection, sliceStart);
     }
+    first = (first + 1) % MAX_CONNECTIONS;
 }
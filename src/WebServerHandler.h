@@ -1,6 +1,14 @@
 #ifndef WEBSERVERHANDLER_H
 #define WEBSERVERHANDLER_H
 
+#include <Arduino.h>
+
 void handleWebRequests();
 
+// Response generators, also used by the benchmark firmware
+void sendStateResponse(Print &client);
+void sendTimeResponse(Print &client);
+void sendDashboard(Print &client);
+void sendVectorResponse(Print &client, int32_t x, int32_t y, int32_t z);
+
 #endif
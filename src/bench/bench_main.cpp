@@ -0,0 +1,199 @@
+// Benchmark firmware for the Nano 33 IoT (env:bench).
+//
+// Times the hot paths of the controller and the web server on the board and
+// reports them over Serial, one CSV line per result:
+//
+//   bench,<name>,<iterations>,<min cycles>,<median cycles>,<max cycles>
+//   ram,free,<bytes between heap end and stack>
+//
+// Lines that do not start with "bench," or "ram," (state changes printed by
+// the controller) can be ignored. Code and RAM size per component is printed
+// by scripts/bench_sizes.py at the end of the build.
+//
+// The Cortex-M0+ has no DWT cycle counter and SysTick is owned by millis(),
+// so TC4 and TC5 are chained into a free running 32-bit counter at F_CPU.
+
+#include <Arduino.h>
+#include <WiFiNINA.h>
+#include <stdlib.h>
+#include "TrafficLightController.h"
+#include "WebServerHandler.h"
+#include "ImuReadings.h"
+
+// Referenced by WebServerHandler.cpp, never started here
+WiFiServer server(80);
+
+const int BENCH_ITERATIONS = 101;
+
+static uint32_t samples[BENCH_ITERATIONS];
+static uint32_t counterOverhead = 0;
+
+// Counts bytes instead of sending them, so only the generation cost is measured
+class NullPrint : public Print
+{
+public:
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t *, size_t size) override { return size; }
+};
+
+static NullPrint nullClient;
+
+static void syncTC4()
+{
+    while (TC4->COUNT32.STATUS.bit.SYNCBUSY)
+        ;
+}
+
+static void startCycleCounter()
+{
+    PM->APBCMASK.reg |= PM_APBCMASK_TC4 | PM_APBCMASK_TC5;
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID_TC4_TC5;
+    while (GCLK->STATUS.bit.SYNCBUSY)
+        ;
+
+    TC4->COUNT32.CTRLA.reg = TC_CTRLA_SWRST;
+    syncTC4();
+    TC4->COUNT32.CTRLA.reg = TC_CTRLA_MODE_COUNT32 | TC_CTRLA_PRESCALER_DIV1;
+    syncTC4();
+    TC4->COUNT32.CTRLA.bit.ENABLE = 1;
+    syncTC4();
+}
+
+static inline uint32_t readCycles()
+{
+    TC4->COUNT32.READREQ.reg = TC_READREQ_RREQ | TC_READREQ_ADDR(TC_COUNT32_COUNT_OFFSET);
+    syncTC4();
+    return TC4->COUNT32.COUNT.reg;
+}
+
+static int compareSamples(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Runs body BENCH_ITERATIONS times and prints min/median/max cycles per call.
+static void runBenchmark(const char *name, void (*body)())
+{
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        uint32_t start = readCycles();
+        body();
+        uint32_t cycles = readCycles() - start;
+        samples[i] = cycles > counterOverhead ? cycles - counterOverhead : 0;
+    }
+    qsort(samples, BENCH_ITERATIONS, sizeof(samples[0]), compareSamples);
+
+    Serial.print("bench,");
+    Serial.print(name);
+    Serial.print(",");
+    Serial.print(BENCH_ITERATIONS);
+    Serial.print(",");
+    Serial.print(samples[0]);
+    Serial.print(",");
+    Serial.print(samples[BENCH_ITERATIONS / 2]);
+    Serial.print(",");
+    Serial.println(samples[BENCH_ITERATIONS - 1]);
+}
+
+// --- Benchmarked paths ---
+
+static void benchEmpty()
+{
+}
+
+// State change including setLights() and its debug print
+static void benchSetState()
+{
+    static bool toggle = false;
+    toggle = !toggle;
+    setTrafficLightState(toggle ? "MAIN_YELLOW" : "MAIN_GREEN");
+}
+
+// A pass without a transition, which is what almost every loop() does
+static void benchUpdateIdle()
+{
+    updateTrafficController();
+}
+
+static void benchStateResponse()
+{
+    sendStateResponse(nullClient);
+}
+
+static void benchDashboard()
+{
+    sendDashboard(nullClient);
+}
+
+// Gyroscope counts of a slowly turning board, volatile so nothing is folded at compile time
+static volatile int16_t gyroCounts[3] = {-1234, 567, 8100};
+
+// /gyro as it was: the float scaling of Arduino_LSM6DS3 and print(float, 2)
+static void benchVectorResponseFloat()
+{
+    float x = gyroCounts[0] * 2000.0 / 32768.0;
+    float y = gyroCounts[1] * 2000.0 / 32768.0;
+    float z = gyroCounts[2] * 2000.0 / 32768.0;
+    nullClient.println("HTTP/1.1 200 OK");
+    nullClient.println("Content-Type: application/json");
+    nullClient.println("Connection: close");
+    nullClient.println();
+    nullClient.print("{\"x\":");
+    nullClient.print(x, 2);
+    nullClient.print(",\"y\":");
+    nullClient.print(y, 2);
+    nullClient.print(",\"z\":");
+    nullClient.print(z, 2);
+    nullClient.println("}");
+}
+
+// /gyro now: integer scaling and JsonWriter
+static void benchVectorResponseFixed()
+{
+    sendVectorResponse(nullClient, rotationCentiDps(gyroCounts[0]), rotationCentiDps(gyroCounts[1]),
+                       rotationCentiDps(gyroCounts[2]));
+}
+
+extern "C" char *sbrk(int increment);
+
+static void reportFreeRam()
+{
+    char top;
+    Serial.print("ram,free,");
+    Serial.println((unsigned long)(&top - sbrk(0)));
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial)
+        ;
+
+    initTrafficController();
+
+    Serial.print("# bench v1 f_cpu=");
+    Serial.println((unsigned long)F_CPU);
+
+    startCycleCounter();
+
+    // Cost of reading the counter itself, subtracted from every later sample
+    runBenchmark("overhead", benchEmpty);
+    counterOverhead = samples[0];
+
+    runBenchmark("setTrafficLightState", benchSetState);
+    initTrafficController();
+    runBenchmark("updateTrafficController", benchUpdateIdle);
+    runBenchmark("stateResponse", benchStateResponse);
+    runBenchmark("dashboard", benchDashboard);
+    runBenchmark("vectorResponseFloat", benchVectorResponseFloat);
+    runBenchmark("vectorResponseFixed", benchVectorResponseFixed);
+    reportFreeRam();
+
+    Serial.println("# done");
+}
+
+void loop()
+{
+}
@@ -0,0 +1,97 @@
+#include "SupervisorClient.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include "SupervisoryLink.h"
+
+int openSerialPort(const char *path)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0)
+        return -1;
+
+    // Raw bytes, no echo and no line editing; the baud rate means nothing on USB CDC
+    termios settings;
+    if (tcgetattr(fd, &settings) == 0)
+    {
+        cfmakeraw(&settings);
+        cfsetspeed(&settings, B115200);
+        settings.c_cc[VMIN] = 0;
+        settings.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &settings);
+    }
+    return fd;
+}
+
+bool SupervisorClient::receive(Frame &frame, int timeoutMs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;)
+    {
+        while (pendingStart < pendingEnd)
+        {
+            if (reader.feed(pending[pendingStart++], frame))
+                return true;
+        }
+
+        int remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining < 0)
+            return false;
+        pollfd wait = {fd, POLLIN, 0};
+        if (poll(&wait, 1, remaining) <= 0)
+            return false;
+
+        ssize_t n = read(fd, pending, sizeof(pending));
+        if (n <= 0)
+            return false;
+        pendingStart = 0;
+        pendingEnd = n;
+    }
+}
+
+bool SupervisorClient::request(uint8_t type, const uint8_t *payload, uint8_t length, Frame &answer, int timeoutMs)
+{
+    Frame frame;
+    frame.type = type;
+    frame.sequence = ++sequence;
+    frame.length = length < MAX_FRAME_PAYLOAD ? length : MAX_FRAME_PAYLOAD;
+    memcpy(frame.payload, payload, frame.length);
+
+    uint8_t encoded[MAX_ENCODED_FRAME];
+    size_t size = encodeFrame(frame, encoded);
+    if (write(fd, encoded, size) != (ssize_t)size)
+        return false;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;)
+    {
+        int remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining < 0 || !receive(answer, remaining))
+            return false;
+        if (answer.type == LINK_EVENT)
+        {
+            if (eventHandler)
+                eventHandler(answer);
+        }
+        // Late answers to earlier requests that timed out are skipped
+        else if (answer.type == (type | LINK_RESPONSE) && answer.sequence == frame.sequence)
+            return true;
+    }
+}
+
+void printLatencies(const char *name, std::vector<double> &us)
+{
+    if (us.empty())
+    {
+        printf("%-14s n=0\n", name);
+        return;
+    }
+    std::sort(us.begin(), us.end());
+    size_t n = us.size();
+    printf("%-14s n=%-6zu p50 %7.0f  p90 %7.0f  p99 %7.0f  max %7.0f us\n", name, n, us[n / 2], us[n * 9 / 10],
+           us[std::min(n - 1, n * 99 / 100)], us[n - 1]);
+}
@@ -0,0 +1,44 @@
+#ifndef SUPERVISOR_CLIENT_H
+#define SUPERVISOR_CLIENT_H
+
+// Host side of the supervisory link (SupervisoryLink.h) on Linux: opens the
+// serial port of the board or a pty and exchanges frames with the controller.
+
+#include <stdint.h>
+#include <vector>
+#include "FrameCodec.h"
+
+// Opens a tty in raw mode. Returns -1 if it cannot be opened.
+int openSerialPort(const char *path);
+
+class SupervisorClient
+{
+public:
+    explicit SupervisorClient(int fd) : fd(fd), sequence(0), eventHandler(NULL), pendingStart(0), pendingEnd(0) {}
+
+    // Sends a request and waits for the answer with the same sequence number.
+    // Events arriving in between go to the event handler. False on timeout.
+    bool request(uint8_t type, const uint8_t *payload, uint8_t length, Frame &answer, int timeoutMs = 1000);
+
+    // Waits for the next frame of any type. False on timeout.
+    bool receive(Frame &frame, int timeoutMs);
+
+    void setEventHandler(void (*handler)(const Frame &event)) { eventHandler = handler; }
+
+    // Chunks between delimiters that were no valid frame, mostly text printed by the firmware
+    unsigned long droppedChunks() const { return reader.dropped; }
+
+private:
+    int fd;
+    uint8_t sequence;
+    void (*eventHandler)(const Frame &event);
+    FrameReader reader;
+    uint8_t pending[512];
+    size_t pendingStart;
+    size_t pendingEnd;
+};
+
+// Prints "<name>  n=.. p50 .. p90 .. p99 .. max .. us" for round-trip times in us (sorts them).
+void printLatencies(const char *name, std::vector<double> &us);
+
+#endif // SUPERVISOR_CLIENT_H
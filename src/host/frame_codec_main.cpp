@@ -0,0 +1,183 @@
+// Host check of the supervisory link framing (FrameCodec.h).
+//
+//   pio run -e frame_codec
+//   .pio/build/frame_codec/program
+//
+// Round-trips the COBS edge cases (empty input, zeros at either end, only
+// zeros, runs of 253 to 255 and 508 non-zero bytes around the 254 byte block
+// limit) and random data through cobsEncode()/cobsDecode(). Then feeds
+// encoded frames to a FrameReader with text and broken frames in between:
+// frames with a bad CRC, cut short or too long must be dropped without
+// losing the frames after them. Returns 1 on a failure.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "FrameCodec.h"
+
+const size_t MAX_TEST_LENGTH = 600;
+const int RANDOM_ROUNDS = 100000;
+
+static unsigned long failures = 0;
+
+static void fail(const char *what, size_t length)
+{
+    if (failures < 10)
+        printf("FAIL: %s (%zu bytes)\n", what, length);
+    failures++;
+}
+
+static void roundTrip(const uint8_t *data, size_t length)
+{
+    uint8_t encoded[MAX_TEST_LENGTH + MAX_TEST_LENGTH / 254 + 1];
+    uint8_t decoded[MAX_TEST_LENGTH];
+    size_t encodedLength = cobsEncode(data, length, encoded);
+    if (encodedLength > length + length / 254 + 1)
+        fail("encoding longer than documented", length);
+    if (memchr(encoded, 0, encodedLength))
+        fail("zero in the encoding", length);
+
+    size_t decodedLength = cobsDecode(encoded, encodedLength, decoded, sizeof(decoded));
+    if (decodedLength != length || memcmp(data, decoded, length) != 0)
+        fail("decoding differs", length);
+
+    // The decoder must refuse output that does not fit instead of writing past it
+    if (length > 0 && cobsDecode(encoded, encodedLength, decoded, length - 1) != 0)
+        fail("decoded into a buffer that is too small", length);
+}
+
+static void checkCobs()
+{
+    uint8_t data[MAX_TEST_LENGTH] = {0};
+    roundTrip(data, 0);
+
+    const size_t runs[] = {1, 253, 254, 255, 508};
+    for (size_t run : runs)
+    {
+        for (size_t i = 0; i < run; i++)
+            data[i] = 1 + i % 255;
+        roundTrip(data, run);
+
+        // Zero before, after and on both sides of the run
+        memmove(data + 1, data, run);
+        data[0] = 0;
+        roundTrip(data, run + 1);
+        data[run + 1] = 0;
+        roundTrip(data, run + 2);
+        roundTrip(data + 1, run + 1);
+    }
+
+    memset(data, 0, sizeof(data));
+    roundTrip(data, 1);
+    roundTrip(data, 300);
+
+    for (int round = 0; round < RANDOM_ROUNDS; round++)
+    {
+        size_t length = rand() % MAX_TEST_LENGTH;
+        // Mostly sparse zeros, sometimes none at all so that long runs occur
+        int zeroOdds = round % 5 == 0 ? 0 : 1 + rand() % 16;
+        for (size_t i = 0; i < length; i++)
+            data[i] = zeroOdds && rand() % zeroOdds == 0 ? 0 : 1 + rand() % 255;
+        roundTrip(data, length);
+    }
+}
+
+static Frame randomFrame()
+{
+    Frame frame;
+    frame.type = rand();
+    frame.sequence = rand();
+    frame.length = rand() % (MAX_FRAME_PAYLOAD + 1);
+    for (uint8_t i = 0; i < frame.length; i++)
+        frame.payload[i] = rand() % 3 == 0 ? 0 : rand();
+    // Zeros at either end of the payload
+    if (frame.length > 0 && rand() % 4 == 0)
+        frame.payload[0] = 0;
+    if (frame.length > 0 && rand() % 4 == 0)
+        frame.payload[frame.length - 1] = 0;
+    return frame;
+}
+
+static bool sameFrame(const Frame &a, const Frame &b)
+{
+    return a.type == b.type && a.sequence == b.sequence && a.length == b.length &&
+           memcmp(a.payload, b.payload, a.length) == 0;
+}
+
+// Good frames with text and broken frames in between; the reader has to return
+// exactly the good ones, in order
+static void checkReader()
+{
+    std::vector<uint8_t> stream;
+    std::vector<Frame> expected;
+    unsigned long broken = 0;
+
+    for (int round = 0; round < RANDOM_ROUNDS / 10; round++)
+    {
+        Frame frame = randomFrame();
+        uint8_t encoded[MAX_ENCODED_FRAME];
+        size_t length = encodeFrame(frame, encoded);
+        bool good = true;
+
+        switch (rand() % 6)
+        {
+        case 0:
+        {
+            // Text the firmware printed between frames
+            const char *text = "Setting state to: MAIN_GREEN\r\n";
+            stream.insert(stream.end(), text, text + strlen(text));
+            break;
+        }
+        case 1:
+            // Bad CRC: one flipped bit in the last CRC byte, kept free of zeros
+            encoded[length - 2] = encoded[length - 2] == 0x01 ? 0x03 : encoded[length - 2] ^ 0x01;
+            good = false;
+            break;
+        case 2:
+            // Cut short, the rest of the frame was lost
+            length = 2 + rand() % (length - 3);
+            encoded[length++] = FRAME_DELIMITER;
+            good = false;
+            break;
+        case 3:
+            // More bytes than any frame has before the next delimiter
+            for (size_t i = 0; i < MAX_ENCODED_FRAME + 10; i++)
+                stream.push_back(1 + rand() % 255);
+            break;
+        default:
+            break;
+        }
+        stream.insert(stream.end(), encoded, encoded + length);
+        if (good)
+            expected.push_back(frame);
+        else
+            broken++;
+    }
+
+    FrameReader reader;
+    Frame received;
+    size_t next = 0;
+    for (uint8_t c : stream)
+    {
+        if (!reader.feed(c, received))
+            continue;
+        if (next >= expected.size() || !sameFrame(received, expected[next]))
+            fail("reader returned a frame that was not sent", received.length);
+        next++;
+    }
+    if (next != expected.size())
+        fail("reader lost good frames", expected.size() - next);
+    if (reader.dropped < broken)
+        fail("reader did not drop the broken frames", broken - reader.dropped);
+    printf("%zu frames, %lu broken ones and %lu chunks dropped\n", expected.size(), broken, reader.dropped);
+}
+
+int main()
+{
+    checkCobs();
+    checkReader();
+    printf("%lu failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+// Host check of the fixed point IMU formatting (ImuReadings.h, JsonWriter.h).
+//
+//   pio run -e json_format
+//   .pio/build/json_format/program
+//
+// Formats every one of the 65536 counts of both sensors through
+// accelerationCentiG()/rotationCentiDps() and JsonWriter::fixed(), and
+// compares the text with what the float path of Arduino_LSM6DS3 and
+// Print::print(float, 2) gave before. Accepted differences are "-0.00" for
+// tiny negative readings, which the fixed point path writes as "0.00", and
+// readings exactly halfway between two hundredths: Print rounds by adding
+// 0.005 in double, which sometimes ends just below the half, the fixed point
+// path always rounds them away from zero. Also checks the longest /gyro body, the reaction to a full buffer
+// and nesting beyond the depth the writer tracks. Returns 1 on a failure.
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "ImuReadings.h"
+#include "JsonWriter.h"
+
+// Collects printed text like a WiFiClient would send it
+class TextPrint : public Print
+{
+public:
+    size_t write(uint8_t c) override
+    {
+        if (length + 1 < sizeof(text))
+        {
+            text[length++] = c;
+            text[length] = '\0';
+        }
+        return 1;
+    }
+
+    char text[32] = "";
+    size_t length = 0;
+};
+
+static unsigned long failures = 0;
+
+static void expect(bool condition, const char *what, const char *text)
+{
+    if (condition)
+        return;
+    if (failures < 10)
+        printf("FAIL: %s: %s\n", what, text);
+    failures++;
+}
+
+static void formatCentis(char *text, size_t size, int32_t centis)
+{
+    JsonWriter json(text, size);
+    json.fixed(centis, 2);
+}
+
+// Both scales over the whole int16_t range
+static void checkCounts()
+{
+    unsigned long negativeZeros = 0;
+    unsigned long halvesDown = 0;
+    for (uint8_t sensor = 0; sensor < 2; sensor++)
+    {
+        for (int32_t counts = -32768; counts <= 32767; counts++)
+        {
+            int32_t centis = sensor ? rotationCentiDps(counts) : accelerationCentiG(counts);
+            char body[16];
+            formatCentis(body, sizeof(body), centis);
+
+            // What Arduino_LSM6DS3 computes (in double, stored as float), printed like the old response did
+            float reading = sensor ? counts * (double)ROTATION_RANGE_DPS / 32768.0
+                                   : counts * (double)ACCELERATION_RANGE_G / 32768.0;
+            TextPrint old;
+            old.print(reading, 2);
+            if (strcmp(body, old.text) == 0)
+                continue;
+
+            // Exact halves: Print adds 0.005 in double, which can land just below the half
+            char towardZero[16];
+            formatCentis(towardZero, sizeof(towardZero), centis < 0 ? centis + 1 : centis - 1);
+            bool half = fmod(fabs(reading) * 100.0, 1.0) == 0.5;
+
+            if (strcmp(old.text, "-0.00") == 0 && strcmp(body, "0.00") == 0)
+                negativeZeros++;
+            else if (half && strcmp(old.text, towardZero) == 0)
+                halvesDown++;
+            else
+                expect(false, sensor ? "rotation differs from the float path" : "acceleration differs from the float path",
+                       body);
+        }
+    }
+    printf("131072 counts formatted, %lu times 0.00 instead of -0.00, %lu exact halves rounded up instead of down\n",
+           negativeZeros, halvesDown);
+}
+
+static void checkWriter()
+{
+    // The longest /gyro body has to fit the buffer of sendVectorResponse()
+    char body[48];
+    JsonWriter json(body, sizeof(body));
+    json.beginObject();
+    json.key("x");
+    json.fixed(rotationCentiDps(-32768), 2);
+    json.key("y");
+    json.fixed(rotationCentiDps(-32768), 2);
+    json.key("z");
+    json.fixed(rotationCentiDps(-32768), 2);
+    json.endObject();
+    expect(json.ok() && strcmp(body, "{\"x\":-2000.00,\"y\":-2000.00,\"z\":-2000.00}") == 0, "longest body", body);
+
+    // A full buffer is reported and the text stays terminated
+    char small[8];
+    JsonWriter cut(small, sizeof(small));
+    cut.beginObject();
+    cut.key("x");
+    cut.value((int32_t)123456);
+    cut.endObject();
+    expect(!cut.ok() && strlen(small) == sizeof(small) - 1, "full buffer", small);
+
+    // Nesting too deep is reported, the levels around it keep their commas
+    char nested[64];
+    JsonWriter deep(nested, sizeof(nested));
+    for (uint8_t i = 0; i < 8; i++)
+        deep.beginArray();
+    deep.value((int32_t)1);
+    deep.beginObject();
+    deep.key("x");
+    deep.value((int32_t)2);
+    deep.endObject();
+    for (uint8_t i = 0; i < 7; i++)
+        deep.endArray();
+    deep.value((int32_t)3);
+    deep.endArray();
+    expect(!deep.ok(), "nesting too deep not reported", nested);
+    expect(strcmp(nested, "[[[[[[[[1,{\"x\":2}]]]]]]],3]") == 0, "nesting too deep", nested);
+}
+
+int main()
+{
+    checkCounts();
+    checkWriter();
+    printf("%lu failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+// Host test harness for the supervisory link: the controller runs with
+// SupervisoryLink on one side of a pty, a client on the other side measures
+// round-trip times of the commands.
+//
+//   pio run -e link_harness
+//   .pio/build/link_harness/program                 2000 rounds, then the latencies
+//   .pio/build/link_harness/program --count 10000
+//   .pio/build/link_harness/program --serve         only the controller, prints the pty for env:supervisor
+//
+// The firmware loop runs in the main thread on real time and prints its
+// usual text into the pty as well, so the client has to skip it like on the
+// board. Events are streamed the whole time and checked for gaps.
+
+#include <Arduino.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "JunctionConfig.h"
+#include "TrafficLightController.h"
+#include "PlanScheduler.h"
+#include "SupervisoryLink.h"
+#include "host/SupervisorClient.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static unsigned long eventCount = 0;
+static unsigned long eventsLost = 0;
+
+static void countEvent(const Frame &event)
+{
+    static bool first = true;
+    static uint8_t expected = 0;
+    if (!first)
+        eventsLost += (uint8_t)(event.sequence - expected);
+    first = false;
+    expected = event.sequence + 1;
+    eventCount++;
+}
+
+struct Measurement
+{
+    const char *name;
+    uint8_t type;
+    std::vector<double> rtt; // us
+    unsigned long failures = 0;
+};
+
+// Runs every command count times in turn and times each round trip
+static void runClient(int fd, int count, std::vector<Measurement> *measurements, std::atomic<bool> *done)
+{
+    SupervisorClient client(fd);
+    client.setEventHandler(countEvent);
+
+    Frame answer;
+    uint8_t on = 1;
+    client.request(LINK_STREAM_EVENTS, &on, 1, answer);
+
+    for (int i = 0; i < count; i++)
+    {
+        for (Measurement &measurement : *measurements)
+        {
+            uint8_t payload[8] = {0};
+            uint8_t length = 0;
+            switch (measurement.type)
+            {
+            case LINK_PING:
+                putUint32(payload, i);
+                length = 4;
+                break;
+            case LINK_GET_PLAN:
+                payload[0] = i % TIMING_PLAN_COUNT;
+                length = 1;
+                break;
+            case LINK_SET_STATE:
+                // Back and forth between the first two phases of the cycle
+                payload[0] = PHASE_SEQUENCE[i % 2];
+                length = 1;
+                break;
+            case LINK_SELECT_PLAN:
+                payload[0] = i % 2 ? FOLLOW_SCHEDULE : DEFAULT_TIMING_PLAN;
+                length = 1;
+                break;
+            }
+
+            Clock::time_point start = Clock::now();
+            if (client.request(measurement.type, payload, length, answer) && answer.payload[0] == LINK_OK)
+                measurement.rtt.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+            else
+                measurement.failures++;
+        }
+    }
+
+    // Collect the events that are still on their way
+    while (client.receive(answer, 100))
+    {
+        if (answer.type == LINK_EVENT)
+            countEvent(answer);
+    }
+    printf("%lu chunks skipped (text between frames)\n", client.droppedChunks());
+    *done = true;
+}
+
+static void firmwarePass()
+{
+    updatePlanScheduler();
+    updateTrafficController();
+    updateSupervisoryLink();
+}
+
+int main(int argc, char **argv)
+{
+    int count = 2000;
+    bool serveOnly = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+            count = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--serve") == 0)
+            serveOnly = true;
+        else
+        {
+            fprintf(stderr, "usage: %s [--count <n>] [--serve]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0)
+    {
+        perror("pty");
+        return 1;
+    }
+    const char *portName = ptsname(master);
+
+    // The client side goes raw before the firmware writes anything, or the pty would echo it back
+    int port = openSerialPort(portName);
+    if (port < 0)
+    {
+        perror(portName);
+        return 1;
+    }
+
+    hostUseRealTime();
+    hostSetSerialPort(master);
+    initTrafficController();
+    initPlanScheduler();
+    initSupervisoryLink();
+
+    if (serveOnly)
+    {
+        printf("Controller on %s\n", portName);
+        fflush(stdout);
+        for (;;)
+            firmwarePass();
+    }
+
+    std::vector<Measurement> measurements(5);
+    measurements[0].name = "ping";
+    measurements[0].type = LINK_PING;
+    measurements[1].name = "status";
+    measurements[1].type = LINK_GET_STATUS;
+    measurements[2].name = "read plan";
+    measurements[2].type = LINK_GET_PLAN;
+    measurements[3].name = "set state";
+    measurements[3].type = LINK_SET_STATE;
+    measurements[4].name = "select plan";
+    measurements[4].type = LINK_SELECT_PLAN;
+
+    std::atomic<bool> done(false);
+    std::thread client(runClient, port, count, &measurements, &done);
+    while (!done)
+        firmwarePass();
+    client.join();
+
+    unsigned long failures = 0;
+    for (Measurement &measurement : measurements)
+    {
+        printLatencies(measurement.name, measurement.rtt);
+        failures += measurement.failures;
+    }
+    printf("%lu failed requests, %lu events streamed, %lu lost\n", failures, eventCount, eventsLost);
+    return failures == 0 && eventsLost == 0 ? 0 : 1;
+}
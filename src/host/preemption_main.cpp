@@ -0,0 +1,116 @@
+// Host check of the preemption timing with a simulated clock.
+//
+//   pio run -e preemption
+//   .pio/build/preemption/program
+//
+// Preempts to PREEMPTION_PHASE at several points of a pedestrian green and
+// checks that the pedestrian greens still blink for their whole blinking tail
+// before the phase is left. Then preempts right after a vehicle green started
+// and checks that it is shown for MINIMUM_GREEN. The blink timer is ticked
+// every BLINK_TICK_MS like its interrupt would, and the pin levels are read
+// back, so blinking means the lamps really went dark. Returns 1 on a failure.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include "JunctionConfig.h"
+#include "TrafficLightController.h"
+#include "LampDriver.h"
+#include "BlinkTimer.h"
+
+extern TrafficLightState currentState;
+
+const unsigned long START_TIME = 1000;
+const unsigned long RUN_TIME = 60000;
+
+// The first blink half period is lit, so the first dark one comes this much after the start
+const unsigned long FIRST_DARK_DELAY = 250;
+
+static bool pedestrianGreenDark()
+{
+    for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
+    {
+        if (SIGNAL_GROUPS[i].pedestrian && readLamp(SIGNAL_GROUPS[i].green) && digitalRead(SIGNAL_GROUPS[i].green) == LOW)
+            return true;
+    }
+    return false;
+}
+
+// Starts phase at START_TIME, preempts offset ms later and runs until the
+// target is shown. Returns how long the phase was shown and when its lamps
+// first blinked dark (0 if never), both relative to the phase start.
+static bool runCase(TrafficLightState phase, unsigned long offset, unsigned long &shown, unsigned long &firstDark)
+{
+    hostResetPins();
+    hostSetMillis(START_TIME);
+    initTrafficController();
+    setTrafficLightPhase(phase);
+
+    shown = 0;
+    firstDark = 0;
+    bool left = false;
+    for (unsigned long t = START_TIME; t < START_TIME + RUN_TIME; t += BLINK_TICK_MS)
+    {
+        hostSetMillis(t);
+        if (t == START_TIME + offset)
+            requestPreemption(PREEMPTION_PHASE);
+        hostBlinkTimerTick();
+        updateTrafficController();
+
+        if (!left && currentState == phase && !firstDark && pedestrianGreenDark())
+            firstDark = t - START_TIME;
+        if (!left && currentState != phase)
+        {
+            left = true;
+            shown = t - START_TIME;
+        }
+        if (currentState == PREEMPTION_PHASE)
+        {
+            releasePreemption();
+            return left;
+        }
+    }
+    releasePreemption();
+    return false;
+}
+
+int main()
+{
+    hostSetSerialOutput(false);
+    unsigned long failures = 0;
+
+    const Phase &pedestrian = PHASES[PEDESTRIAN_PHASE];
+    const unsigned long pedestrianOffsets[] = {0, 1000, 4000, 6000, 7500, 9000};
+    for (unsigned long offset : pedestrianOffsets)
+    {
+        unsigned long shown, firstDark;
+        bool reached = runCase((TrafficLightState)PEDESTRIAN_PHASE, offset, shown, firstDark);
+        bool ok = reached && firstDark && shown - firstDark + FIRST_DARK_DELAY >= pedestrian.blinkTail;
+        printf("%s preempted after %5lu ms: shown %5lu ms, blinking from %5lu ms  %s\n", pedestrian.name, offset, shown,
+               firstDark ? firstDark - FIRST_DARK_DELAY : 0, ok ? "ok" : "FAIL: blinking tail cut short");
+        if (!ok)
+            failures++;
+    }
+
+    // A vehicle green that just started, on the way to the preemption target
+    for (uint8_t i = 0; i < PHASE_COUNT; i++)
+    {
+        const Phase &phase = PHASES[i];
+        if (i == PREEMPTION_PHASE || (phase.flags & PHASE_FLASHING) || phase.blinkTail || phase.duration < MINIMUM_GREEN)
+            continue;
+        bool vehicleGreen = false;
+        for (uint8_t j = 0; j < SIGNAL_GROUP_COUNT; j++)
+            vehicleGreen |= !SIGNAL_GROUPS[j].pedestrian && phase.aspects[j] == ASPECT_GREEN;
+        if (!vehicleGreen)
+            continue;
+
+        unsigned long shown, firstDark;
+        bool reached = runCase((TrafficLightState)i, 100, shown, firstDark);
+        bool ok = reached && shown >= MINIMUM_GREEN;
+        printf("%s preempted after   100 ms: shown %5lu ms  %s\n", phase.name, shown, ok ? "ok" : "FAIL: shorter than MINIMUM_GREEN");
+        if (!ok)
+            failures++;
+    }
+
+    printf("%lu failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
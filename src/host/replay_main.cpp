@@ -0,0 +1,245 @@
+// Host replay of a capture downloaded from /capture.
+//
+//   pio run -e replay
+//   .pio/build/replay/program capture.txt            diff the lamp outputs
+//   .pio/build/replay/program capture.txt --bench 1000   also time the replay
+//
+// The controller is restored from the capture's snapshot and every event is fed
+// back at its recorded millis(). After each event the lamp outputs are compared
+// with the ones the board recorded; any difference is printed.
+//
+// env:replay_shift_register builds the same replay against the shift register
+// lamp driver and also checks every emitted frame against the lamp outputs.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include "PinDefinitions.h"
+#include "TrafficLightController.h"
+#include "InputRecorder.h"
+#include "JunctionConfig.h"
+#include "LampDriver.h"
+#include "BlinkTimer.h"
+
+extern TrafficLightState currentState;
+
+static const char *const EVENT_NAMES[] = {"PEDESTRIAN_BUTTON", "VEHICLE_SENSOR", "WEB_SET", "TICK", "PLAN", "LAMP_FALLBACK", "PREEMPT", "PREEMPT_RELEASE"};
+
+static bool loadCapture(FILE *file, TrafficControllerSnapshot &snapshot, std::vector<RecordedEvent> &events)
+{
+    char line[128];
+    bool haveSnapshot = false;
+    while (fgets(line, sizeof(line), file))
+    {
+        if (line[0] == 'S')
+        {
+            unsigned long time, state, step, ped, veh, active, pending, start, preempt, preemptTime;
+            if (sscanf(line, "S,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu", &time, &state, &step, &ped, &veh, &active,
+                       &pending, &start, &preempt, &preemptTime) != 10)
+                return false;
+            snapshot.time = time;
+            snapshot.state = state;
+            snapshot.sequenceStep = step;
+            snapshot.pedestrianFlag = ped;
+            snapshot.vehicleFlag = veh;
+            snapshot.activePlan = active;
+            snapshot.pendingPlan = pending;
+            snapshot.stateStartTime = start;
+            snapshot.preemptTarget = preempt;
+            snapshot.preemptTime = preemptTime;
+            haveSnapshot = true;
+        }
+        else if (line[0] == 'C')
+        {
+            // Custom timing plan: mode, then one duration per phase
+            char *next = line + 1;
+            for (uint8_t i = 0; i <= PHASE_COUNT; i++)
+            {
+                if (*next != ',')
+                    return false;
+                unsigned long value = strtoul(next + 1, &next, 10);
+                if (i == 0)
+                    snapshot.customMode = value;
+                else
+                    snapshot.customDurations[i - 1] = value;
+            }
+        }
+        else if (strncmp(line, "# capture ", 10) == 0 && strncmp(line, "# capture v6", 12) != 0)
+        {
+            return false;
+        }
+        else if (line[0] == 'E')
+        {
+            unsigned long time, type, arg, lamps;
+            if (sscanf(line, "E,%lu,%lu,%lu,%lx", &time, &type, &arg, &lamps) != 4 || type > EVENT_PREEMPT_RELEASE)
+                return false;
+            RecordedEvent event = {(uint32_t)time, (uint8_t)type, (uint8_t)arg, (uint32_t)lamps};
+            events.push_back(event);
+        }
+        else if (strstr(line, "overflow"))
+        {
+            fprintf(stderr, "warning: capture overflowed, replay ends early\n");
+        }
+    }
+    return haveSnapshot;
+}
+
+// Puts the buttons in the state setup() leaves them in, then restores the controller.
+static void resetBoard(const TrafficControllerSnapshot &snapshot)
+{
+    hostResetPins();
+    hostSetMillis(snapshot.time);
+    pinMode(PED_BUTTON, INPUT_PULLUP);
+    pinMode(VEHICLE_BUTTON, INPUT_PULLUP);
+    initLampDriver();
+    initBlinkTimer();
+    restoreTrafficControllerSnapshot(snapshot);
+}
+
+#if LAMP_DRIVER == LAMP_DRIVER_SHIFT_REGISTER
+// Decodes the last frame sent to the shift registers into the same bit mask
+// as sampleLampOutputs(), to check what actually reached the lamps.
+static uint32_t frameLampOutputs()
+{
+    const uint8_t *frame = hostLastLampFrame();
+    uint32_t mask = 0;
+    uint8_t bit = 0;
+    for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
+    {
+        const int lamps[] = {SIGNAL_GROUPS[i].red, SIGNAL_GROUPS[i].yellow, SIGNAL_GROUPS[i].green};
+        for (uint8_t j = 0; j < 3 && bit < 32; j++)
+        {
+            if (lamps[j] == NO_PIN)
+                continue;
+            uint8_t reg = frame[SHIFT_REGISTER_COUNT - 1 - lamps[j] / 8];
+            if (reg & (1 << (lamps[j] % 8)))
+                mask |= 1UL << bit;
+            bit++;
+        }
+    }
+    return mask;
+}
+#endif
+
+// Feeds one event to the controller the same way the firmware received it.
+static void applyEvent(const RecordedEvent &event)
+{
+    hostSetMillis(event.time);
+    switch (event.type)
+    {
+    case EVENT_PEDESTRIAN_BUTTON:
+        handlePedestrianButton();
+        break;
+    case EVENT_VEHICLE_SENSOR:
+        handleVehicleButton();
+        break;
+    case EVENT_WEB_SET:
+        setTrafficLightPhase(event.arg);
+        break;
+    case EVENT_TICK:
+        updateTrafficController();
+        break;
+    case EVENT_PLAN:
+        requestTimingPlan(event.arg);
+        break;
+    case EVENT_LAMP_FALLBACK:
+        hostTriggerBlinkTimerFallback();
+        updateTrafficController();
+        break;
+    case EVENT_PREEMPT:
+        requestPreemption(event.arg);
+        break;
+    case EVENT_PREEMPT_RELEASE:
+        releasePreemption();
+        break;
+    }
+}
+
+// Returns the number of events whose lamp outputs differ from the capture.
+static size_t replay(const TrafficControllerSnapshot &snapshot, const std::vector<RecordedEvent> &events, bool printDiff)
+{
+    resetBoard(snapshot);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        const RecordedEvent &event = events[i];
+        applyEvent(event);
+
+        uint32_t lamps = sampleLampOutputs();
+#if LAMP_DRIVER == LAMP_DRIVER_SHIFT_REGISTER
+        // Lamps that were written but never latched would show up here
+        uint32_t latched = frameLampOutputs();
+        if (latched != lamps)
+        {
+            mismatches++;
+            if (printDiff)
+                printf("#%zu t=%lu: shift register frame %05lx does not match lamps %05lx\n",
+                       i, (unsigned long)event.time, (unsigned long)latched, (unsigned long)lamps);
+        }
+#endif
+        bool stateMismatch = (event.type == EVENT_TICK || event.type == EVENT_LAMP_FALLBACK) && currentState != event.arg;
+        if (lamps != event.lamps || stateMismatch)
+        {
+            mismatches++;
+            if (printDiff)
+            {
+                printf("#%zu t=%lu %s", i, (unsigned long)event.time, EVENT_NAMES[event.type]);
+                if (event.type == EVENT_WEB_SET || event.type == EVENT_TICK || event.type == EVENT_LAMP_FALLBACK ||
+                    event.type == EVENT_PREEMPT)
+                    printf(" %s", getStateName((TrafficLightState)event.arg));
+                printf(": lamps recorded=%05lx replayed=%05lx (diff %05lx)",
+                       (unsigned long)event.lamps, (unsigned long)lamps, (unsigned long)(event.lamps ^ lamps));
+                if (stateMismatch)
+                    printf(", replay is in %s", getStateName(currentState));
+                printf("\n");
+            }
+        }
+    }
+    return mismatches;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <capture.txt> [--bench <iterations>]\n", argv[0]);
+        return 2;
+    }
+
+    FILE *file = fopen(argv[1], "r");
+    if (!file)
+    {
+        perror(argv[1]);
+        return 2;
+    }
+    TrafficControllerSnapshot snapshot = {};
+    std::vector<RecordedEvent> events;
+    bool loaded = loadCapture(file, snapshot, events);
+    fclose(file);
+    if (!loaded)
+    {
+        fprintf(stderr, "%s: not a capture file\n", argv[1]);
+        return 2;
+    }
+
+    hostSetSerialOutput(false);
+    size_t mismatches = replay(snapshot, events, true);
+    printf("%zu events replayed, %zu mismatches\n", events.size(), mismatches);
+
+    // Captures double as a benchmark corpus for the controller
+    if (argc >= 4 && strcmp(argv[2], "--bench") == 0)
+    {
+        long iterations = atol(argv[3]);
+        auto begin = std::chrono::steady_clock::now();
+        for (long i = 0; i < iterations; i++)
+            replay(snapshot, events, false);
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - begin).count();
+        if (iterations > 0 && !events.empty())
+            printf("bench: %ld iterations, %.1f ns/event\n", iterations, ns / iterations / events.size());
+    }
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+// Host simulation of the timing plan scheduler with a simulated clock.
+//
+//   pio run -e schedule
+//   .pio/build/schedule/program [start epoch] [days]
+//
+// Runs the controller and the scheduler for the given number of days (default
+// one week from Monday 2026-10-19 00:00) in 10 ms steps and prints when a plan
+// is requested and when the controller actually switches, together with the
+// phase it switched in. A switch outside a cycle boundary is reported as an
+// error.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "JunctionConfig.h"
+#include "TrafficLightController.h"
+#include "PlanScheduler.h"
+
+extern TrafficLightState currentState;
+
+const unsigned long STEP_MS = 10;
+
+static void printTime(uint32_t epoch)
+{
+    printClock(Serial, epoch);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t start = argc > 1 ? strtoul(argv[1], NULL, 10) : 1792368000UL;
+    unsigned long days = argc > 2 ? strtoul(argv[2], NULL, 10) : 7;
+
+    hostSetSerialOutput(false);
+    hostSetMillis(0);
+    initTrafficController();
+    initPlanScheduler();
+    setClock(start);
+
+    uint8_t scheduled = scheduledTimingPlan(start);
+    uint8_t active = getActiveTimingPlan();
+    unsigned long cycles[TIMING_PLAN_COUNT] = {0};
+    unsigned long errors = 0;
+    TrafficLightState previousState = currentState;
+
+    unsigned long steps = days * 86400UL * (1000 / STEP_MS);
+    for (unsigned long i = 0; i < steps; i++)
+    {
+        hostAdvanceMillis(STEP_MS);
+        updatePlanScheduler();
+        updateTrafficController();
+
+        uint8_t nowScheduled = scheduledTimingPlan(getClock());
+        if (nowScheduled != scheduled)
+        {
+            scheduled = nowScheduled;
+            hostSetSerialOutput(true);
+            printTime(getClock());
+            hostSetSerialOutput(false);
+            printf("  requested %s\n", TIMING_PLANS[scheduled].name);
+        }
+
+        if (getActiveTimingPlan() != active)
+        {
+            active = getActiveTimingPlan();
+
+            // Plans may only change when the cycle starts over, from flashing or while resting in green
+            bool boundary = currentState == PHASE_SEQUENCE[0] || currentState == FLASHING_PHASE ||
+                            previousState == FLASHING_PHASE || previousState == PHASE_SEQUENCE[0];
+            if (!boundary)
+                errors++;
+
+            hostSetSerialOutput(true);
+            printTime(getClock());
+            hostSetSerialOutput(false);
+            printf("  active %s from %s to %s%s\n", TIMING_PLANS[active].name, getStateName(previousState),
+                   getStateName(currentState), boundary ? "" : "  ERROR: not at a cycle boundary");
+        }
+
+        if (currentState != previousState && currentState == PHASE_SEQUENCE[0])
+            cycles[active]++;
+        previousState = currentState;
+    }
+
+    for (uint8_t i = 0; i < TIMING_PLAN_COUNT; i++)
+        printf("%s: %lu cycles\n", TIMING_PLANS[i].name, cycles[i]);
+    printf("%lu errors\n", errors);
+    return errors == 0 ? 0 : 1;
+}
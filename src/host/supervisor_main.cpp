@@ -0,0 +1,291 @@
+// Supervisory tool for the cabinet PC, speaks the binary protocol of
+// SupervisoryLink.h over the USB serial port of the board (or the pty of
+// env:link_harness).
+//
+//   pio run -e supervisor
+//   .pio/build/supervisor/program /dev/ttyACM0 status
+//   .pio/build/supervisor/program /dev/ttyACM0 ping 1000        round-trip latency
+//   .pio/build/supervisor/program /dev/ttyACM0 set SIDE_GREEN
+//   .pio/build/supervisor/program /dev/ttyACM0 clock now        local time of this PC
+//   .pio/build/supervisor/program /dev/ttyACM0 plan 1|custom    show a timing plan
+//   .pio/build/supervisor/program /dev/ttyACM0 write cycle 20000 0 0 0 8000
+//                                                               write the custom plan: mode, ms per phase (0 = default)
+//   .pio/build/supervisor/program /dev/ttyACM0 select 2|custom|auto  hold a plan, or follow the schedule
+//   .pio/build/supervisor/program /dev/ttyACM0 preempt MAIN_GREEN | release
+//   .pio/build/supervisor/program /dev/ttyACM0 capture start|stop
+//   .pio/build/supervisor/program /dev/ttyACM0 events           stream inputs until Ctrl-C
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include <vector>
+#include "JunctionConfig.h"
+#include "InputRecorder.h"
+#include "PlanScheduler.h"
+#include "SupervisoryLink.h"
+#include "host/SupervisorClient.h"
+
+static const char *const RESULT_NAMES[] = {"OK", "bad argument", "refused", "unknown request", "bad length"};
+static const char *const EVENT_NAMES[] = {"PED", "VEH", "SET", "TICK", "PLAN", "FALLBACK", "PREEMPT", "RELEASE"};
+
+static int phaseByName(const char *name)
+{
+    for (uint8_t i = 0; i < PHASE_COUNT; i++)
+    {
+        if (strcmp(name, PHASES[i].name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static const char *const MODE_NAMES[] = {"cycle", "rest", "flashing"};
+
+static const char *planName(uint8_t plan)
+{
+    if (plan == FOLLOW_SCHEDULE)
+        return "schedule";
+    if (plan == CUSTOM_TIMING_PLAN)
+        return "CUSTOM";
+    return plan < TIMING_PLAN_COUNT ? TIMING_PLANS[plan].name : "?";
+}
+
+// Plan index from the command line: a number or "custom"
+static uint8_t planIndex(const char *arg)
+{
+    return strcmp(arg, "custom") == 0 ? CUSTOM_TIMING_PLAN : atoi(arg);
+}
+
+// Lamps in sampleLampOutputs() order as R/Y/G letters per signal group, '.' when dark
+static void printLamps(uint32_t lamps)
+{
+    uint8_t bit = 0;
+    for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
+    {
+        const SignalGroup &group = SIGNAL_GROUPS[i];
+        const int pins[] = {group.red, group.yellow, group.green};
+        printf(" %s:", group.name);
+        for (uint8_t j = 0; j < 3 && bit < 32; j++)
+        {
+            if (pins[j] == NO_PIN)
+                continue;
+            putchar(lamps & (1UL << bit) ? "RYG"[j] : '.');
+            bit++;
+        }
+    }
+}
+
+static void printEvent(const Frame &frame)
+{
+    static bool first = true;
+    static uint8_t expected = 0;
+    if (!first && frame.sequence != expected)
+        printf("(%u events lost)\n", (uint8_t)(frame.sequence - expected));
+    first = false;
+    expected = frame.sequence + 1;
+
+    uint8_t type = frame.payload[4];
+    uint8_t arg = frame.payload[5];
+    printf("%10lu ms  %-8s", (unsigned long)getUint32(frame.payload), type < 8 ? EVENT_NAMES[type] : "?");
+    if (type == EVENT_PLAN)
+        printf(" %-16s", planName(arg));
+    else if (type == EVENT_WEB_SET || type == EVENT_TICK || type == EVENT_LAMP_FALLBACK || type == EVENT_PREEMPT)
+        printf(" %-16s", arg < PHASE_COUNT ? PHASES[arg].name : "?");
+    else
+        printf(" %-16s", "");
+    printLamps(getUint32(frame.payload + 6));
+    printf("\n");
+    fflush(stdout);
+}
+
+static void printStatus(const Frame &answer)
+{
+    const uint8_t *in = answer.payload;
+    uint8_t state = in[STATUS_STATE];
+    printf("state     %s\n", state < PHASE_COUNT ? PHASES[state].name : "?");
+    printf("lamps    ");
+    printLamps(getUint32(in + STATUS_LAMPS));
+    printf("\nplan      %s (held: %s)\n", planName(in[STATUS_ACTIVE_PLAN]), planName(in[STATUS_PLAN_OVERRIDE]));
+
+    if (in[STATUS_CLOCK_SET])
+    {
+        time_t clock = getUint32(in + STATUS_CLOCK);
+        char text[32];
+        strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S %a", gmtime(&clock));
+        printf("clock     %s\n", text);
+    }
+    else
+        printf("clock     not set\n");
+    printf("uptime    %lu ms\n", (unsigned long)getUint32(in + STATUS_MILLIS));
+
+    uint8_t target = in[STATUS_PREEMPT_TARGET];
+    if (target == NO_PHASE)
+        printf("preempt   none");
+    else
+        printf("preempt   %s %s", target < PHASE_COUNT ? PHASES[target].name : "?",
+               in[STATUS_PREEMPT_REACHED] ? "reached" : "pending");
+    printf(" (latency %lu ms)\n", (unsigned long)getUint32(in + STATUS_PREEMPT_LATENCY));
+    printf("capture   %s, %u events\n", in[STATUS_RECORDING] ? "recording" : "stopped", getUint16(in + STATUS_EVENT_COUNT));
+}
+
+static void printPlan(const Frame &answer)
+{
+    const uint8_t *in = answer.payload;
+    uint8_t phases = in[3];
+    size_t nameStart = 4 + phases * 4;
+    printf("plan %u: %.*s, %s\n", in[1], (int)(answer.length - nameStart), (const char *)in + nameStart,
+           in[2] < 3 ? MODE_NAMES[in[2]] : "?");
+    for (uint8_t i = 0; i < phases; i++)
+        printf("  %-18s %6lu ms\n", i < PHASE_COUNT ? PHASES[i].name : "?", (unsigned long)getUint32(in + 4 + i * 4));
+}
+
+static void printUsage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s <port> status | ping [count] | set <STATE> | clock <epoch|now> | plan <n|custom> |\n"
+            "       write <cycle|rest|flashing> [ms per phase...] | select <n|custom|auto> |\n"
+            "       preempt <STATE> | release | capture start|stop | events\n",
+            program);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+    int fd = openSerialPort(argv[1]);
+    if (fd < 0)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    SupervisorClient client(fd);
+    const char *command = argv[2];
+    const char *arg = argc > 3 ? argv[3] : "";
+
+    uint8_t type;
+    uint8_t payload[MAX_FRAME_PAYLOAD];
+    uint8_t length = 0;
+
+    if (strcmp(command, "ping") == 0)
+    {
+        int count = argc > 3 ? atoi(arg) : 100;
+        std::vector<double> rtt;
+        for (int i = 0; i < count; i++)
+        {
+            Frame answer;
+            putUint32(payload, i);
+            auto start = std::chrono::steady_clock::now();
+            if (client.request(LINK_PING, payload, 4, answer))
+                rtt.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        }
+        printLatencies("ping", rtt);
+        printf("%d lost, %lu chunks skipped\n", count - (int)rtt.size(), client.droppedChunks());
+        return rtt.size() == (size_t)count ? 0 : 1;
+    }
+    else if (strcmp(command, "events") == 0)
+    {
+        Frame answer;
+        payload[0] = 1;
+        if (!client.request(LINK_STREAM_EVENTS, payload, 1, answer))
+        {
+            fprintf(stderr, "no answer\n");
+            return 1;
+        }
+        for (;;)
+        {
+            Frame frame;
+            if (client.receive(frame, 1000) && frame.type == LINK_EVENT)
+                printEvent(frame);
+        }
+    }
+    else if (strcmp(command, "status") == 0)
+        type = LINK_GET_STATUS;
+    else if (strcmp(command, "set") == 0 || strcmp(command, "preempt") == 0)
+    {
+        int phase = phaseByName(arg);
+        if (phase < 0)
+        {
+            fprintf(stderr, "unknown state %s\n", arg);
+            return 2;
+        }
+        type = command[0] == 's' ? LINK_SET_STATE : LINK_PREEMPT;
+        payload[length++] = phase;
+    }
+    else if (strcmp(command, "clock") == 0)
+    {
+        // The controller runs on local time
+        time_t now = time(NULL);
+        struct tm local;
+        localtime_r(&now, &local);
+        uint32_t epoch = strcmp(arg, "now") == 0 ? now + local.tm_gmtoff : strtoul(arg, NULL, 10);
+        type = LINK_SET_CLOCK;
+        putUint32(payload, epoch);
+        length = 4;
+    }
+    else if (strcmp(command, "plan") == 0)
+    {
+        type = LINK_GET_PLAN;
+        payload[length++] = planIndex(arg);
+    }
+    else if (strcmp(command, "write") == 0)
+    {
+        int mode = -1;
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            if (strcmp(arg, MODE_NAMES[i]) == 0)
+                mode = i;
+        }
+        if (mode < 0 || argc - 4 > PHASE_COUNT)
+        {
+            printUsage(argv[0]);
+            return 2;
+        }
+        type = LINK_SET_PLAN;
+        payload[length++] = mode;
+        payload[length++] = PHASE_COUNT;
+        for (uint8_t i = 0; i < PHASE_COUNT; i++, length += 4)
+            putUint32(payload + length, 4 + i < argc ? strtoul(argv[4 + i], NULL, 10) : 0);
+    }
+    else if (strcmp(command, "select") == 0)
+    {
+        type = LINK_SELECT_PLAN;
+        payload[length++] = strcmp(arg, "auto") == 0 ? FOLLOW_SCHEDULE : planIndex(arg);
+    }
+    else if (strcmp(command, "release") == 0)
+        type = LINK_RELEASE;
+    else if (strcmp(command, "capture") == 0 && strcmp(arg, "start") == 0)
+        type = LINK_START_CAPTURE;
+    else if (strcmp(command, "capture") == 0 && strcmp(arg, "stop") == 0)
+        type = LINK_STOP_CAPTURE;
+    else
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    Frame answer;
+    if (!client.request(type, payload, length, answer))
+    {
+        fprintf(stderr, "no answer\n");
+        return 1;
+    }
+    uint8_t result = answer.payload[0];
+    if (result != LINK_OK)
+    {
+        fprintf(stderr, "%s\n", result < 5 ? RESULT_NAMES[result] : "error");
+        return 1;
+    }
+
+    if (type == LINK_GET_STATUS)
+        printStatus(answer);
+    else if (type == LINK_GET_PLAN)
+        printPlan(answer);
+    else
+        printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,267 @@
+// Host build of the web server on TCP sockets, with a load generator.
+//
+//   pio run -e webserver
+//   .pio/build/webserver/program                         4 clients for 10 s
+//   .pio/build/webserver/program --clients 16 --seconds 30 --think 500
+//   .pio/build/webserver/program --serve                 only serve, open http://localhost:8080/
+//
+// The firmware loop (scheduler, controller, web server) runs in the main
+// thread on real time, the load clients each in their own thread. A client
+// requests the routes in ROUTES one after the other, waiting --think ms in
+// between like a polling dashboard. At the end the requests/s and latency
+// percentiles per route are printed, together with the intervals between
+// controller updates (tick jitter) under that load.
+
+#include <Arduino.h>
+#include <WiFiNINA.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "TrafficLightController.h"
+#include "WebServerHandler.h"
+#include "PlanScheduler.h"
+#include "MemoryMonitor.h"
+
+WiFiServer server(8080);
+
+typedef std::chrono::steady_clock Clock;
+
+// The dashboard page and the routes its scripts poll
+static const char *const ROUTES[] = {"/", "/state", "/time", "/gyro", "/accel", "/memory", "/preempt"};
+const int ROUTE_COUNT = sizeof(ROUTES) / sizeof(ROUTES[0]);
+
+const int RESPONSE_TIMEOUT_S = 5;
+
+struct RouteStats
+{
+    std::vector<double> latencies; // ms
+    unsigned long errors = 0;
+};
+
+struct ClientOptions
+{
+    uint16_t port;
+    unsigned long thinkMs;
+    Clock::time_point deadline;
+};
+
+// One request on a new connection. Returns the time until the server closed
+// the connection in ms, or a negative value on errors and non-200 answers.
+static double timeRequest(uint16_t port, const char *route)
+{
+    Clock::time_point start = Clock::now();
+
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    timeval timeout = {RESPONSE_TIMEOUT_S, 0};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (connect(sock, (sockaddr *)&address, sizeof(address)) < 0)
+    {
+        close(sock);
+        return -1;
+    }
+
+    char request[128];
+    int length = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n", route);
+    if (send(sock, request, length, MSG_NOSIGNAL) != length)
+    {
+        close(sock);
+        return -1;
+    }
+
+    char status[13] = {0};
+    size_t received = 0;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(sock, buffer, sizeof(buffer), 0)) > 0)
+    {
+        for (ssize_t i = 0; i < n && received < sizeof(status) - 1; i++)
+            status[received++] = buffer[i];
+    }
+    close(sock);
+    if (n < 0 || strcmp(status, "HTTP/1.1 200") != 0)
+        return -1;
+
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static void runClient(int index, ClientOptions options, std::vector<RouteStats> *stats)
+{
+    for (int route = index % ROUTE_COUNT; Clock::now() < options.deadline; route = (route + 1) % ROUTE_COUNT)
+    {
+        double latency = timeRequest(options.port, ROUTES[route]);
+        if (latency < 0)
+            (*stats)[route].errors++;
+        else
+            (*stats)[route].latencies.push_back(latency);
+
+        if (options.thinkMs)
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.thinkMs));
+    }
+}
+
+// Intervals between controller updates in 10 us buckets, up to 1 s
+const unsigned long JITTER_BUCKET_US = 10;
+const size_t JITTER_BUCKETS = 100000;
+
+static std::vector<unsigned long> jitter(JITTER_BUCKETS + 1);
+static unsigned long jitterCount = 0;
+static unsigned long jitterMax = 0;
+
+static void recordInterval(unsigned long us)
+{
+    jitter[std::min<size_t>(us / JITTER_BUCKET_US, JITTER_BUCKETS)]++;
+    jitterCount++;
+    jitterMax = std::max(jitterMax, us);
+}
+
+// Upper bound of the bucket that holds the given fraction of all intervals
+static unsigned long jitterPercentile(double fraction)
+{
+    unsigned long wanted = (unsigned long)(fraction * jitterCount);
+    unsigned long seen = 0;
+    for (size_t i = 0; i <= JITTER_BUCKETS; i++)
+    {
+        seen += jitter[i];
+        if (seen > wanted)
+            return i == JITTER_BUCKETS ? jitterMax : (i + 1) * JITTER_BUCKET_US;
+    }
+    return jitterMax;
+}
+
+static double percentile(const std::vector<double> &sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0;
+    return sorted[std::min(sorted.size() - 1, (size_t)(fraction * sorted.size()))];
+}
+
+// Same order as loop() in main.cpp, without the buttons
+static void firmwarePass()
+{
+    updatePlanScheduler();
+    updateTrafficController();
+    handleWebRequests();
+    updateMemoryMonitor();
+}
+
+static void printUsage(const char *program)
+{
+    fprintf(stderr, "usage: %s [--port <port>] [--clients <n>] [--seconds <s>] [--think <ms>] [--serve]\n", program);
+}
+
+int main(int argc, char **argv)
+{
+    uint16_t port = 8080;
+    int clients = 4;
+    unsigned long seconds = 10;
+    unsigned long thinkMs = 0;
+    bool serveOnly = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--port") == 0 && hasValue)
+            port = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--clients") == 0 && hasValue)
+            clients = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seconds") == 0 && hasValue)
+            seconds = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--think") == 0 && hasValue)
+            thinkMs = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--serve") == 0)
+            serveOnly = true;
+        else
+        {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    hostSetSerialOutput(serveOnly);
+    hostUseRealTime();
+    initMemoryMonitor();
+    server = WiFiServer(port);
+    server.begin();
+    initTrafficController();
+    initPlanScheduler();
+    markMemorySteadyState();
+
+    if (serveOnly)
+    {
+        printf("Serving on http://localhost:%u/\n", port);
+        for (;;)
+            firmwarePass();
+    }
+
+    ClientOptions options = {port, thinkMs, Clock::now() + std::chrono::seconds(seconds)};
+    std::vector<std::vector<RouteStats>> stats(clients, std::vector<RouteStats>(ROUTE_COUNT));
+    std::atomic<int> running(clients);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < clients; i++)
+    {
+        threads.emplace_back([i, options, &stats, &running]() {
+            runClient(i, options, &stats[i]);
+            running--;
+        });
+    }
+
+    // Keep serving until the last client has its final answer
+    Clock::time_point start = Clock::now();
+    Clock::time_point lastUpdate = start;
+    while (running > 0)
+    {
+        firmwarePass();
+        Clock::time_point now = Clock::now();
+        recordInterval(std::chrono::duration_cast<std::chrono::microseconds>(now - lastUpdate).count());
+        lastUpdate = now;
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    for (std::thread &thread : threads)
+        thread.join();
+
+    printf("%d clients, %.1f s, think %lu ms\n\n", clients, elapsed, thinkMs);
+    printf("%-10s %9s %8s %8s %8s %8s %8s %7s\n", "route", "requests", "req/s", "p50 ms", "p90 ms", "p99 ms", "max ms", "errors");
+
+    std::vector<double> all;
+    unsigned long allErrors = 0;
+    for (int route = 0; route < ROUTE_COUNT; route++)
+    {
+        std::vector<double> latencies;
+        unsigned long errors = 0;
+        for (int i = 0; i < clients; i++)
+        {
+            latencies.insert(latencies.end(), stats[i][route].latencies.begin(), stats[i][route].latencies.end());
+            errors += stats[i][route].errors;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        all.insert(all.end(), latencies.begin(), latencies.end());
+        allErrors += errors;
+
+        printf("%-10s %9zu %8.1f %8.2f %8.2f %8.2f %8.2f %7lu\n", ROUTES[route], latencies.size(),
+               latencies.size() / elapsed, percentile(latencies, 0.5), percentile(latencies, 0.9),
+               percentile(latencies, 0.99), latencies.empty() ? 0 : latencies.back(), errors);
+    }
+    std::sort(all.begin(), all.end());
+    printf("%-10s %9zu %8.1f %8.2f %8.2f %8.2f %8.2f %7lu\n", "all", all.size(), all.size() / elapsed,
+           percentile(all, 0.5), percentile(all, 0.9), percentile(all, 0.99), all.empty() ? 0 : all.back(), allErrors);
+
+    printf("\ncontroller updates: %lu, interval p50 %lu us, p99 %lu us, p99.9 %lu us, max %lu us\n", jitterCount,
+           jitterPercentile(0.5), jitterPercentile(0.99), jitterPercentile(0.999), jitterMax);
+
+    return allErrors == 0 ? 0 : 1;
+}
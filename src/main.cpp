@@ -6,6 +6,11 @@
 #include "TestLamps.h"
 #include "TrafficLightController.h"
 #include "WebServerHandler.h"
+#include "PlanScheduler.h"
+#include "JunctionConfig.h"
+#include "MemoryMonitor.h"
+#include "ImuReadings.h"
+#include "SupervisoryLink.h"
 
 WiFiServer server(80);
 
@@ -37,6 +42,7 @@ WiFiServer server(80);
 // Buttons:
 // - Pedestrian button: A1
 // - Vehicle detection button: D2
+// - Emergency vehicle preemption input: A3 (active LOW)
 //
 // Traffic Flow Logic:
 // - The main road runs from left to right (traffic light 1 to traffic light 3).
@@ -50,33 +56,15 @@ WiFiServer server(80);
 
 void setup()
 {
+  initMemoryMonitor();
   Serial.begin(9600);
 
   // Initialize buttons and built-in LED
   pinMode(PED_BUTTON, INPUT_PULLUP);
   pinMode(VEHICLE_BUTTON, INPUT_PULLUP);
+  pinMode(PREEMPT_INPUT, INPUT_PULLUP);
   pinMode(LED_BUILTIN, OUTPUT);
 
-  // Initialize all lamp pins
-  pinMode(LAMP1_RED, OUTPUT);
-  pinMode(LAMP1_YELLOW, OUTPUT);
-  pinMode(LAMP1_GREEN, OUTPUT);
-  pinMode(LAMP1_GREEN_PED, OUTPUT);
-  pinMode(LAMP1_RED_PED, OUTPUT);
-
-  pinMode(LAMP2_RED, OUTPUT);
-  pinMode(LAMP2_YELLOW, OUTPUT);
-  pinMode(LAMP2_GREEN, OUTPUT);
-  pinMode(LAMP2_GREEN_PED, OUTPUT);
-  pinMode(LAMP2_RED_PED, OUTPUT);
-
-  pinMode(LAMP3_RED, OUTPUT);
-  pinMode(LAMP3_YELLOW, OUTPUT);
-  pinMode(LAMP3_GREEN, OUTPUT);
-
-  digitalWrite(LAMP1_RED_PED, HIGH);
-  digitalWrite(LAMP2_RED_PED, HIGH);
-
   // Initialize WiFi
   if (WiFi.status() == WL_NO_MODULE)
   {
@@ -98,15 +86,18 @@ void setup()
   }
   Serial.println("IMU initialized");
   Serial.print("Gyroscope sample rate = ");
-  Serial.print(IMU.gyroscopeSampleRate());
+  Serial.print(IMU_SAMPLE_RATE_HZ);
   Serial.println(" Hz");
   Serial.println("Gyroscope in degrees/second");
   Serial.print("Accelerometer sample rate = ");
-  Serial.print(IMU.accelerationSampleRate());
+  Serial.print(IMU_SAMPLE_RATE_HZ);
   Serial.println("Hz");
 
-  // Initialize the traffic light controller module
+  // Initialize the traffic light controller module (also sets up all lamp pins)
   initTrafficController();
+  initPlanScheduler();
+  initSupervisoryLink();
+  markMemorySteadyState();
 }
 
 void loop()
@@ -121,9 +112,25 @@ void loop()
     handleVehicleButton();
   }
 
-  // Update the traffic light state machine
+  // Emergency vehicle preemption, held as long as the input is LOW
+  static bool preemptInput = false;
+  bool preempt = digitalRead(PREEMPT_INPUT) == LOW;
+  if (preempt != preemptInput)
+  {
+    preemptInput = preempt;
+    if (preempt)
+      requestPreemption(PREEMPTION_PHASE);
+    else
+      releasePreemption();
+  }
+
+  // Switch timing plans by time of day, then update the traffic light state machine
+  updatePlanScheduler();
   updateTrafficController();
 
-  // Handle web requests
+  // Handle web requests and the supervisory link on the USB port
   handleWebRequests();
+  updateSupervisoryLink();
+
+  updateMemoryMonitor();
 }
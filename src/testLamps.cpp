@@ -1,45 +1,22 @@
 #include "TestLamps.h"
+#include "JunctionConfig.h"
+#include "LampDriver.h"
 
 void testLamps()
 {
     // teste die Ampel, indem nacheinander jede LED eingeschaltet wird
-    digitalWrite(LAMP1_RED, HIGH);
-    delay(500);
-    digitalWrite(LAMP1_RED, LOW);
-    digitalWrite(LAMP1_YELLOW, HIGH);
-    delay(500);
-    digitalWrite(LAMP1_YELLOW, LOW);
-    digitalWrite(LAMP1_GREEN, HIGH);
-    delay(500);
-    digitalWrite(LAMP1_GREEN, LOW);
-    digitalWrite(LAMP1_RED_PED, HIGH);
-    delay(500);
-    digitalWrite(LAMP1_RED_PED, LOW);
-    digitalWrite(LAMP1_GREEN_PED, HIGH);
-    delay(500);
-    digitalWrite(LAMP1_GREEN_PED, LOW);
-    digitalWrite(LAMP2_RED, HIGH);
-    delay(500);
-    digitalWrite(LAMP2_RED, LOW);
-    digitalWrite(LAMP2_YELLOW, HIGH);
-    delay(500);
-    digitalWrite(LAMP2_YELLOW, LOW);
-    digitalWrite(LAMP2_GREEN, HIGH);
-    delay(500);
-    digitalWrite(LAMP2_GREEN, LOW);
-    digitalWrite(LAMP2_RED_PED, HIGH);
-    delay(500);
-    digitalWrite(LAMP2_RED_PED, LOW);
-    digitalWrite(LAMP2_GREEN_PED, HIGH);
-    delay(500);
-    digitalWrite(LAMP2_GREEN_PED, LOW);
-    digitalWrite(LAMP3_RED, HIGH);
-    delay(500);
-    digitalWrite(LAMP3_RED, LOW);
-    digitalWrite(LAMP3_YELLOW, HIGH);
-    delay(500);
-    digitalWrite(LAMP3_YELLOW, LOW);
-    digitalWrite(LAMP3_GREEN, HIGH);
-    delay(500);
-    digitalWrite(LAMP3_GREEN, LOW);
-}
\ No newline at end of file
+    for (uint8_t i = 0; i < SIGNAL_GROUP_COUNT; i++)
+    {
+        const int pins[] = {SIGNAL_GROUPS[i].red, SIGNAL_GROUPS[i].yellow, SIGNAL_GROUPS[i].green};
+        for (uint8_t j = 0; j < 3; j++)
+        {
+            if (pins[j] == NO_PIN)
+                continue;
+            writeLamp(pins[j], true);
+            latchLamps();
+            delay(500);
+            writeLamp(pins[j], false);
+            latchLamps();
+        }
+    }
+}